@@ -0,0 +1,451 @@
+#include "hash_table.hpp"
+#include "hash_table_utils.hpp"
+#include "string_pool.hpp"
+#include "durable_hash_table.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hash_table;
+using namespace hash_table_utils;
+
+/// <summary>
+/// A single operation of a workload trace.
+/// </summary>
+struct TraceOp {
+	/// <summary>
+	/// Operation type, 'I' (insert), 'G' (get) or 'R' (remove).
+	/// </summary>
+	char type;
+
+	/// <summary>
+	/// Key of the operation.
+	/// </summary>
+	wstring key;
+
+	/// <summary>
+	/// Value of the operation (insert only).
+	/// </summary>
+	wstring value;
+};
+
+/// <summary>
+/// Options given on the command line.
+/// </summary>
+struct BenchmarkOptions {
+	string trace_path;
+	string generate_path;
+	string wal_path;
+	unsigned long group_size = 1024;
+	unsigned long buckets = 100000;
+	unsigned long ops = 1000000;
+	unsigned long key_space = 100000;
+	unsigned int insert_percent = 40;
+	unsigned int get_percent = 50;
+	unsigned int seed = 1;
+	unsigned int repeat = 1;
+	double bloom_bits = 0;
+	unsigned long memory_max = 0;
+	bool latency = true;
+};
+
+//forward declares
+int print_usage();
+bool parse_options(int argc, char** argv, BenchmarkOptions& options);
+bool generate_trace(const BenchmarkOptions& options);
+bool load_trace(const string& path, vector<TraceOp>& trace);
+void replay_trace(const vector<TraceOp>& trace, const BenchmarkOptions& options);
+template <typename TABLE>
+double replay_throughput(TABLE& table, const vector<TraceOp>& trace, unsigned long long& hits);
+template <typename TABLE>
+void replay_latency(TABLE& table, const vector<TraceOp>& trace);
+void memory_sweep(const BenchmarkOptions& options);
+string encode_utf8(const wstring& text);
+wstring decode_utf8(const string& text);
+
+int main(int argc, char** argv) {
+	BenchmarkOptions options;
+
+	if (!parse_options(argc, argv, options)) return print_usage();
+
+	//write a synthetic trace
+	if (!options.generate_path.empty()) {
+		if (!generate_trace(options)) {
+			wcerr << L"Could not write trace file." << endl;
+			return 1;
+		}
+
+		wcout << L"Wrote " << options.ops << L" operations to " << decode_utf8(options.generate_path) << endl;
+	}
+
+	//replay a trace
+	if (!options.trace_path.empty()) {
+		vector<TraceOp> trace;
+
+		if (!load_trace(options.trace_path, trace)) {
+			wcerr << L"Could not read trace file." << endl;
+			return 1;
+		}
+
+		replay_trace(trace, options);
+	}
+
+	//report memory per entry over growing table sizes
+	if (options.memory_max > 0) memory_sweep(options);
+
+	return 0;
+}
+
+//prints the command line usage
+int print_usage() {
+	wcerr << L"Usage: hash_table_benchmark [options]\n\n";
+	wcerr << L"  --trace FILE       Replay a trace file and report throughput, latency and peak RSS.\n";
+	wcerr << L"  --generate FILE    Write a synthetic trace file (written before --trace is replayed).\n";
+	wcerr << L"  --buckets N        Number of table buckets (default 100000).\n";
+	wcerr << L"  --repeat N         Replay the trace N times on fresh tables (default 1).\n";
+	wcerr << L"  --latency 0|1      Replay each run a second time on a fresh table timing every operation (default 1).\n";
+	wcerr << L"  --wal PATH         Replay into a DurableHashTable logging to PATH.log (removed before each run).\n";
+	wcerr << L"  --group N          Operations per group commit with --wal (default 1024).\n";
+	wcerr << L"  --memory MAX       Report bytes per entry and peak RSS for 100, 1000, ... items up to MAX.\n";
+	wcerr << L"  --bloom BITS       Put a Bloom filter with BITS bits per key in front of get (default 0, off).\n";
+	wcerr << L"  --ops N            Operations to generate (default 1000000).\n";
+	wcerr << L"  --keys N           Distinct keys to generate (default 100000).\n";
+	wcerr << L"  --insert P         Percent of generated operations which insert (default 40).\n";
+	wcerr << L"  --get P            Percent of generated operations which get (default 50), the rest remove.\n";
+	wcerr << L"  --seed N           Seed for trace generation (default 1).\n\n";
+	wcerr << L"Trace files contain one operation per line, fields separated by tabs:\n";
+	wcerr << L"  I<tab>key<tab>value | G<tab>key | R<tab>key\n";
+	return 2;
+}
+
+//reads the command line into the options, returns false if it is invalid
+bool parse_options(int argc, char** argv, BenchmarkOptions& options) {
+	if (argc < 2) return false;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			string option = argv[i];
+
+			//every option takes a value
+			if (i + 1 >= argc) return false;
+			string value = argv[++i];
+
+			if (option == "--trace") options.trace_path = value;
+			else if (option == "--generate") options.generate_path = value;
+			else if (option == "--buckets") options.buckets = stoul(value);
+			else if (option == "--repeat") options.repeat = (unsigned int)stoul(value);
+			else if (option == "--latency") options.latency = stoul(value) != 0;
+			else if (option == "--bloom") options.bloom_bits = stod(value);
+			else if (option == "--memory") options.memory_max = stoul(value);
+			else if (option == "--wal") options.wal_path = value;
+			else if (option == "--group") options.group_size = stoul(value);
+			else if (option == "--ops") options.ops = stoul(value);
+			else if (option == "--keys") options.key_space = stoul(value);
+			else if (option == "--insert") options.insert_percent = (unsigned int)stoul(value);
+			else if (option == "--get") options.get_percent = (unsigned int)stoul(value);
+			else if (option == "--seed") options.seed = (unsigned int)stoul(value);
+			else return false;
+		}
+	}
+	catch (...) {
+		return false;
+	}
+
+	return options.buckets > 0 && options.key_space > 0 && options.repeat > 0 && options.insert_percent + options.get_percent <= 100
+		&& (!options.trace_path.empty() || !options.generate_path.empty() || options.memory_max > 0);
+}
+
+//writes a synthetic trace using the same names and phone numbers as the unit tests
+bool generate_trace(const BenchmarkOptions& options) {
+	ofstream file(options.generate_path, ios::binary);
+	if (!file) return false;
+
+	srand(options.seed);
+	mt19937 random(options.seed);
+
+	//build the key space up front so that every operation picks from the same keys
+	vector<string> keys(options.key_space);
+	for (unsigned long i = 0; i < options.key_space; i++) {
+		keys[i] = encode_utf8(random_name() + L" " + to_wstring(i));
+	}
+
+	uniform_int_distribution<unsigned long> pick_key(0, options.key_space - 1);
+	uniform_int_distribution<unsigned int> pick_op(0, 99);
+
+	for (unsigned long i = 0; i < options.ops; i++) {
+		const string& key = keys[pick_key(random)];
+		unsigned int op = pick_op(random);
+
+		if (op < options.insert_percent) {
+			file << "I\t" << key << "\t" << encode_utf8(random_phone_number()) << "\n";
+		}
+		else if (op < options.insert_percent + options.get_percent) {
+			file << "G\t" << key << "\n";
+		}
+		else {
+			file << "R\t" << key << "\n";
+		}
+	}
+
+	return (bool)file;
+}
+
+//reads a trace file into memory so that file access is not part of the measurement
+bool load_trace(const string& path, vector<TraceOp>& trace) {
+	ifstream file(path, ios::binary);
+	if (!file) return false;
+
+	string line;
+	while (getline(file, line)) {
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.size() < 3 || line[1] != '\t') continue;
+
+		TraceOp op;
+		op.type = line[0];
+
+		size_t separator = line.find('\t', 2);
+
+		if (op.type == 'I') {
+			if (separator == string::npos) continue;
+
+			op.key = decode_utf8(line.substr(2, separator - 2));
+			op.value = decode_utf8(line.substr(separator + 1));
+		}
+		else if (op.type == 'G' || op.type == 'R') {
+			op.key = decode_utf8(line.substr(2));
+		}
+		else {
+			continue;
+		}
+
+		trace.push_back(op);
+	}
+
+	return true;
+}
+
+//returns the latency at a given percentile of a sorted list of latencies
+long long percentile(const vector<long long>& sorted, double fraction) {
+	if (sorted.empty()) return 0;
+
+	return sorted[(size_t)(fraction * (sorted.size() - 1))];
+}
+
+//prints the latency distribution of one operation type
+void print_latency(const wstring& name, vector<long long>& latencies) {
+	if (latencies.empty()) return;
+
+	sort(latencies.begin(), latencies.end());
+
+	wcout << L"  " << name << L": " << latencies.size() << L" ops"
+		<< L", p50 " << percentile(latencies, 0.50) << L"ns"
+		<< L", p99 " << percentile(latencies, 0.99) << L"ns"
+		<< L", p99.9 " << percentile(latencies, 0.999) << L"ns"
+		<< L", max " << latencies.back() << L"ns" << endl;
+}
+
+//replays a trace against fresh tables and reports the results
+void replay_trace(const vector<TraceOp>& trace, const BenchmarkOptions& options) {
+	//calls replay(table) with a fresh table, returns false if the table could not be created
+	auto with_fresh_table = [&options](auto replay) {
+		if (!options.wal_path.empty()) {
+			filesystem::remove(options.wal_path + ".log");
+			filesystem::remove(options.wal_path + ".snapshot");
+
+			DurableHashTable<wstring, wstring> table(string_hash_function, options.wal_path, options.buckets, options.group_size);
+			if (!table.is_open()) {
+				wcerr << L"Could not open the log." << endl;
+				return false;
+			}
+
+			replay(table);
+		}
+		else {
+			HashTable<wstring, wstring> table(string_hash_function, options.buckets);
+			if (options.bloom_bits > 0) table.enable_bloom_filter(options.key_space, options.bloom_bits);
+
+			replay(table);
+		}
+
+		return true;
+	};
+
+	for (unsigned int run = 1; run <= options.repeat; run++) {
+		//the throughput pass only reads the clock around the whole trace, so the clock's own cost isn't counted per operation
+		bool opened = with_fresh_table([&](auto& table) {
+			unsigned long long hits = 0;
+			double seconds = replay_throughput(table, trace, hits);
+
+			wcout << L"Run " << run << L"/" << options.repeat << L": " << trace.size() << L" ops in " << seconds * 1000.0 << L"ms"
+				<< L" (" << (seconds > 0 ? trace.size() / seconds : 0.0) << L" ops/s)" << endl;
+
+			wcout << L"  get hits: " << hits << L", final size: " << table.size()
+				<< L", peak RSS: " << peak_rss_bytes() / 1024 << L"KB" << endl;
+		});
+
+		if (!opened) return;
+
+		//latencies come from a second pass which reads the clock around every operation
+		if (options.latency && !with_fresh_table([&trace](auto& table) { replay_latency(table, trace); })) return;
+	}
+}
+
+//replays a trace against one table, returns the seconds it took
+template <typename TABLE>
+double replay_throughput(TABLE& table, const vector<TraceOp>& trace, unsigned long long& hits) {
+	auto start = chrono::steady_clock::now();
+
+	for (auto& op : trace) {
+		if (op.type == 'I') {
+			table.insert(op.key, op.value);
+		}
+		else if (op.type == 'G') {
+			if (table.get(op.key) != nullptr) hits++;
+		}
+		else {
+			table.remove(op.key);
+		}
+	}
+
+	auto end = chrono::steady_clock::now();
+
+	return chrono::duration<double>(end - start).count();
+}
+
+//replays a trace against one table timing every operation and reports the latency distributions
+template <typename TABLE>
+void replay_latency(TABLE& table, const vector<TraceOp>& trace) {
+	vector<long long> insert_latency, get_latency, remove_latency;
+
+	for (auto& op : trace) {
+		auto op_start = chrono::steady_clock::now();
+
+		if (op.type == 'I') {
+			table.insert(op.key, op.value);
+		}
+		else if (op.type == 'G') {
+			table.get(op.key);
+		}
+		else {
+			table.remove(op.key);
+		}
+
+		auto op_end = chrono::steady_clock::now();
+		long long latency = chrono::duration_cast<chrono::nanoseconds>(op_end - op_start).count();
+
+		if (op.type == 'I') insert_latency.push_back(latency);
+		else if (op.type == 'G') get_latency.push_back(latency);
+		else remove_latency.push_back(latency);
+	}
+
+	print_latency(L"insert", insert_latency);
+	print_latency(L"get   ", get_latency);
+	print_latency(L"remove", remove_latency);
+}
+
+//fills tables of growing size the same way test_performance does and reports where the memory goes
+void memory_sweep(const BenchmarkOptions& options) {
+	srand(options.seed);
+
+	wcout << L"items\tbuckets\tentries\tnodes\tout of line\tbytes/entry\tinterned bytes/entry\tpeak RSS KB" << endl;
+
+	for (unsigned long size = 100; size <= options.memory_max; size *= 10) {
+		unsigned long buckets = size / 10 > 0 ? size / 10 : 1;
+
+		HashTable<wstring, wstring> table(string_hash_function, buckets);
+
+		//the same data with the text of keys and values interned
+		StringPool pool;
+		HashTable<InternedString, InternedString> interned(interned_hash_function, buckets);
+
+		for (unsigned long i = 0; i < size; i++) {
+			wstring key = random_name(), value = random_phone_number();
+
+			table.insert(key, value);
+			interned.insert(pool.intern(key), pool.intern(value));
+		}
+
+		MemoryUsage usage = table.memory_usage();
+		size_t interned_bytes = interned.memory_usage().total() + pool.memory_usage();
+
+		wcout << size << L"\t" << usage.bucket_array << L"\t" << usage.entries << L"\t" << usage.nodes << L"\t" << usage.out_of_line
+			<< L"\t" << (double)usage.total() / size << L"\t" << (double)interned_bytes / size << L"\t" << peak_rss_bytes() / 1024 << endl;
+
+		//stop before the size would overflow
+		if (size > ULONG_MAX / 10) break;
+	}
+}
+
+//converts a wide string to utf-8
+string encode_utf8(const wstring& text) {
+	string result;
+
+	for (size_t i = 0; i < text.size(); i++) {
+		unsigned long code = (unsigned long)text[i];
+
+		//join utf-16 surrogate pairs (windows wchar_t)
+		if (code >= 0xD800 && code <= 0xDBFF && i + 1 < text.size()) {
+			code = 0x10000 + ((code - 0xD800) << 10) + ((unsigned long)text[++i] - 0xDC00);
+		}
+
+		if (code < 0x80) {
+			result += (char)code;
+		}
+		else if (code < 0x800) {
+			result += (char)(0xC0 | (code >> 6));
+			result += (char)(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000) {
+			result += (char)(0xE0 | (code >> 12));
+			result += (char)(0x80 | ((code >> 6) & 0x3F));
+			result += (char)(0x80 | (code & 0x3F));
+		}
+		else {
+			result += (char)(0xF0 | (code >> 18));
+			result += (char)(0x80 | ((code >> 12) & 0x3F));
+			result += (char)(0x80 | ((code >> 6) & 0x3F));
+			result += (char)(0x80 | (code & 0x3F));
+		}
+	}
+
+	return result;
+}
+
+//converts utf-8 to a wide string
+wstring decode_utf8(const string& text) {
+	wstring result;
+
+	for (size_t i = 0; i < text.size();) {
+		unsigned char lead = (unsigned char)text[i];
+		unsigned long code;
+		int length;
+
+		if (lead < 0x80) { code = lead; length = 1; }
+		else if ((lead >> 5) == 0x6) { code = lead & 0x1F; length = 2; }
+		else if ((lead >> 4) == 0xE) { code = lead & 0x0F; length = 3; }
+		else { code = lead & 0x07; length = 4; }
+
+		for (int j = 1; j < length && i + j < text.size(); j++) {
+			code = (code << 6) | ((unsigned char)text[i + j] & 0x3F);
+		}
+
+		i += length;
+
+		//split into a utf-16 surrogate pair where wchar_t is 16 bits (windows)
+		if (code >= 0x10000 && sizeof(wchar_t) == 2) {
+			code -= 0x10000;
+			result += (wchar_t)(0xD800 + (code >> 10));
+			result += (wchar_t)(0xDC00 + (code & 0x3FF));
+		}
+		else {
+			result += (wchar_t)code;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace hash_table {
+	/// <summary>
+	/// A blocked Bloom filter. Each key sets one bit in each of the eight words of a single 64 byte block,
+	/// so a lookup reads one cache line and checks all eight bits at once.
+	/// </summary>
+	class BloomFilter
+	{
+	public:
+		/// <summary>
+		/// A cache line of filter bits.
+		/// </summary>
+		struct alignas(64) Block {
+			uint64_t words[8];
+		};
+
+	private:
+		//odd constants used to pick one bit per word from a 32 bit hash
+		alignas(32) static constexpr uint32_t SALTS[8] = {
+			0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+			0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+		};
+
+		//bit blocks, block_count is always a power of two
+		Block* blocks;
+		size_t block_count;
+
+		//number of keys the filter was sized for and the number added
+		unsigned long key_capacity;
+		unsigned long key_count = 0;
+
+		/// <summary>
+		/// Get the block of a hash.
+		/// </summary>
+		const Block& block_of(uint64_t hash) const {
+			return this->blocks[(size_t)(hash >> 32) & (this->block_count - 1)];
+		}
+
+		/// <summary>
+		/// Get the bit mask of each word of a block for a hash.
+		/// </summary>
+		static void masks_of(uint64_t hash, uint64_t masks[8]) {
+			uint32_t low = (uint32_t)hash;
+
+			for (int i = 0; i < 8; i++) {
+				masks[i] = 1ull << ((uint32_t)(low * SALTS[i]) >> 26);
+			}
+		}
+
+	public:
+		/// <summary>
+		/// Create a BloomFilter sized for a number of keys.
+		/// </summary>
+		/// <param name="expected_keys">Number of keys the filter is sized for.</param>
+		/// <param name="bits_per_key">Filter bits per key, 10 gives roughly a 1% false positive rate.</param>
+		BloomFilter(unsigned long expected_keys, double bits_per_key = 10) {
+			this->key_capacity = expected_keys == 0 ? 1 : expected_keys;
+
+			//round the block count up to a power of two
+			double bits = this->key_capacity * bits_per_key;
+			this->block_count = 1;
+			while (this->block_count * 512.0 < bits) {
+				this->block_count *= 2;
+			}
+
+			blocks = new Block[this->block_count]();
+		}
+
+		BloomFilter(const BloomFilter& other) {
+			this->block_count = other.block_count;
+			this->key_capacity = other.key_capacity;
+			this->key_count = other.key_count;
+
+			blocks = new Block[this->block_count];
+			std::memcpy(this->blocks, other.blocks, this->block_count * sizeof(Block));
+		}
+
+		BloomFilter& operator= (const BloomFilter&) = delete;
+
+		~BloomFilter() {
+			delete[] this->blocks;
+		}
+
+		/// <summary>
+		/// Add a hashed key to the filter.
+		/// </summary>
+		void add(uint64_t hash) {
+			Block& block = const_cast<Block&>(this->block_of(hash));
+
+			uint64_t masks[8];
+			masks_of(hash, masks);
+
+			for (int i = 0; i < 8; i++) {
+				block.words[i] |= masks[i];
+			}
+
+			this->key_count++;
+		}
+
+		/// <summary>
+		/// Check if a hashed key may have been added, false means it definitely was not.
+		/// </summary>
+		bool may_contain(uint64_t hash) const {
+			const Block& block = this->block_of(hash);
+
+#if defined(__AVX2__)
+			//compute all eight bit positions at once and test them against the block in two halves
+			__m256i products = _mm256_mullo_epi32(_mm256_set1_epi32((int)(uint32_t)hash), _mm256_load_si256((const __m256i*)SALTS));
+			__m256i shifts = _mm256_srli_epi32(products, 26);
+			__m256i one = _mm256_set1_epi64x(1);
+
+			__m256i low_masks = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+			__m256i high_masks = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+
+			__m256i low_words = _mm256_load_si256((const __m256i*)&block.words[0]);
+			__m256i high_words = _mm256_load_si256((const __m256i*)&block.words[4]);
+
+			return _mm256_testc_si256(low_words, low_masks) && _mm256_testc_si256(high_words, high_masks);
+#else
+			uint64_t masks[8];
+			masks_of(hash, masks);
+
+			//no early exit so the compiler can vectorize the check
+			uint64_t missing = 0;
+			for (int i = 0; i < 8; i++) {
+				missing |= masks[i] & ~block.words[i];
+			}
+
+			return missing == 0;
+#endif
+		}
+
+		/// <summary>
+		/// Return the number of keys the filter was sized for.
+		/// </summary>
+		unsigned long capacity() const {
+			return this->key_capacity;
+		}
+
+		/// <summary>
+		/// Return the number of keys added to the filter.
+		/// </summary>
+		unsigned long size() const {
+			return this->key_count;
+		}
+
+		/// <summary>
+		/// Return the number of bytes used by the filter bits.
+		/// </summary>
+		size_t memory_usage() const {
+			return this->block_count * sizeof(Block);
+		}
+	};
+};
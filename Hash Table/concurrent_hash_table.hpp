@@ -0,0 +1,533 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <optional>
+#include <climits>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// Epoch based memory reclamation. Readers enter an epoch while they hold pointers into a shared structure,
+	/// retired objects are only freed once every reader which could still see them has left.
+	/// </summary>
+	class EpochReclaimer
+	{
+	private:
+		/// <summary>
+		/// An object waiting to be freed.
+		/// </summary>
+		struct Retired {
+			void* object;
+			void (*deleter)(void*);
+		};
+
+		//number of retired objects collected before trying to advance the epoch
+		static constexpr size_t RETIRE_THRESHOLD = 64;
+
+		//global epoch, active threads are counted in the slot epoch % 3
+		std::atomic<unsigned long long> epoch{ 0 };
+		std::atomic<long> active[3] = {};
+
+		//objects retired in each epoch slot
+		std::mutex retire_lock;
+		std::vector<Retired> retired[3];
+
+		/// <summary>
+		/// Advance the epoch if no thread is left in the previous one, taking out the objects retired two epochs ago.
+		/// Must be called with retire_lock held, the objects are freed by the caller once it is released.
+		/// </summary>
+		void try_advance(std::vector<Retired>& expired) {
+			unsigned long long current = this->epoch.load();
+
+			if (this->active[(current + 2) % 3].load() != 0) return;
+
+			this->epoch.store(current + 1);
+
+			//nobody can still be in the epoch these objects were retired in
+			expired.swap(this->retired[(current + 1) % 3]);
+		}
+
+		/// <summary>
+		/// Free objects taken out by try_advance.
+		/// </summary>
+		static void free_all(std::vector<Retired>& expired) {
+			for (auto& item : expired) {
+				item.deleter(item.object);
+			}
+
+			expired.clear();
+		}
+
+	public:
+		/// <summary>
+		/// Objects retired by one thread which are handed to the reclaimer together, so retiring many objects takes its lock once.
+		/// Retiring later than the object was unlinked is always safe, it only delays the free.
+		/// </summary>
+		class RetireList {
+			friend EpochReclaimer;
+
+		private:
+			std::vector<Retired> items;
+
+		public:
+			template <typename T>
+			void add(T* object) {
+				this->items.push_back(Retired{ object, [](void* pointer) { delete (T*)pointer; } });
+			}
+		};
+
+		/// <summary>
+		/// Marks the calling thread as active for as long as the guard exists.
+		/// </summary>
+		class Guard {
+		private:
+			EpochReclaimer& reclaimer;
+			unsigned int slot;
+
+		public:
+			Guard(EpochReclaimer& reclaimer) : reclaimer(reclaimer) {
+				while (true) {
+					unsigned long long current = reclaimer.epoch.load();
+					this->slot = (unsigned int)(current % 3);
+
+					reclaimer.active[this->slot].fetch_add(1);
+
+					//make sure the epoch did not move on before we were counted
+					if (reclaimer.epoch.load() == current) break;
+
+					reclaimer.active[this->slot].fetch_sub(1);
+				}
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator= (const Guard&) = delete;
+
+			~Guard() {
+				this->reclaimer.active[this->slot].fetch_sub(1);
+			}
+		};
+
+		EpochReclaimer() {}
+
+		EpochReclaimer(const EpochReclaimer&) = delete;
+		EpochReclaimer& operator= (const EpochReclaimer&) = delete;
+
+		~EpochReclaimer() {
+			this->collect_all();
+		}
+
+		/// <summary>
+		/// Free an object once no reader can still hold a pointer to it.
+		/// </summary>
+		template <typename T>
+		void retire(T* object) {
+			std::vector<Retired> expired;
+
+			{
+				std::lock_guard<std::mutex> lock(this->retire_lock);
+
+				auto& list = this->retired[this->epoch.load() % 3];
+				list.push_back(Retired{ object, [](void* pointer) { delete (T*)pointer; } });
+
+				if (list.size() >= RETIRE_THRESHOLD) this->try_advance(expired);
+			}
+
+			free_all(expired);
+		}
+
+		/// <summary>
+		/// Free every object of a list once no reader can still hold a pointer to it, leaving the list empty.
+		/// </summary>
+		void retire(RetireList& objects) {
+			if (objects.items.empty()) return;
+
+			std::vector<Retired> expired;
+
+			{
+				std::lock_guard<std::mutex> lock(this->retire_lock);
+
+				auto& list = this->retired[this->epoch.load() % 3];
+				list.insert(list.end(), objects.items.begin(), objects.items.end());
+
+				if (list.size() >= RETIRE_THRESHOLD) this->try_advance(expired);
+			}
+
+			objects.items.clear();
+			free_all(expired);
+		}
+
+		/// <summary>
+		/// Free every retired object, only valid when no other thread is using the structure.
+		/// </summary>
+		void collect_all() {
+			std::lock_guard<std::mutex> lock(this->retire_lock);
+
+			for (auto& list : this->retired) {
+				for (auto& item : list) {
+					item.deleter(item.object);
+				}
+
+				list.clear();
+			}
+		}
+	};
+
+	/// <summary>
+	/// A thread safe Hash Table. Lookups never take a lock, writers lock a stripe of buckets.
+	/// When the table grows every writer which touches it helps move buckets into the new table,
+	/// leaving a forwarding marker in each moved bucket which lookups follow without waiting.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class ConcurrentHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+	private:
+		//the table grows once it holds more entries than this fraction of its buckets
+		static constexpr double MAX_LOAD_FACTOR = 0.75;
+
+		//number of buckets a thread claims at a time while moving buckets to a new table
+		static constexpr long TRANSFER_STRIDE = 64;
+
+		//maximum number of bucket locks per table
+		static constexpr size_t MAX_LOCKS = 1024;
+
+		/// <summary>
+		/// An immutable Key/Value pair, updates replace the whole node.
+		/// </summary>
+		struct Node {
+			const KT key;
+			const VT value;
+			const unsigned long long hash;
+			std::atomic<Node*> next;
+
+			Node(const KT& key, const VT& value, unsigned long long hash, Node* next) : key(key), value(value), hash(hash), next(next) {}
+		};
+
+		/// <summary>
+		/// A bucket array and the state of its migration into a larger table.
+		/// </summary>
+		struct Table {
+			size_t size;
+			std::atomic<Node*>* buckets;
+
+			//bucket i is protected by locks[i % lock_count]
+			size_t lock_count;
+			std::mutex* locks;
+
+			//the table buckets are being moved to, nullptr when not resizing
+			std::atomic<Table*> next{ nullptr };
+
+			//the next bucket range to be claimed (counting down) and the number of buckets moved
+			std::atomic<long> transfer_index;
+			std::atomic<long> transfer_done{ 0 };
+
+			Table(size_t size) {
+				this->size = size;
+				this->buckets = new std::atomic<Node*>[size];
+				for (size_t i = 0; i < size; i++) {
+					this->buckets[i].store(nullptr, std::memory_order_relaxed);
+				}
+
+				this->lock_count = size < MAX_LOCKS ? size : MAX_LOCKS;
+				this->locks = new std::mutex[this->lock_count];
+
+				this->transfer_index.store((long)size);
+			}
+
+			~Table() {
+				delete[] this->buckets;
+				delete[] this->locks;
+			}
+
+			std::mutex& lock_for(size_t index) {
+				return this->locks[index % this->lock_count];
+			}
+		};
+
+		//the current table
+		std::atomic<Table*> table;
+
+		//number of Key/Value pairs stored
+		std::atomic<unsigned long> count{ 0 };
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		//frees replaced nodes and old tables once no lookup can reach them
+		EpochReclaimer reclaimer;
+
+		/// <summary>
+		/// Marker stored in a bucket once its nodes have moved to the next table.
+		/// </summary>
+		static Node* moved() {
+			static char marker;
+			return reinterpret_cast<Node*>(&marker);
+		}
+
+		/// <summary>
+		/// Get the full width hash of a key.
+		/// </summary>
+		unsigned long long full_hash(const KT& key) const {
+			return mix_hash(this->hash_function(key, ULONG_MAX));
+		}
+
+		/// <summary>
+		/// Move one bucket of a table into the next table, adding the old nodes to a retire list.
+		/// </summary>
+		void transfer_bucket(Table* old_table, Table* new_table, size_t index, EpochReclaimer::RetireList& moved_nodes) {
+			std::lock_guard<std::mutex> lock(old_table->lock_for(index));
+
+			Node* node = old_table->buckets[index].load();
+			size_t mask = new_table->size - 1;
+
+			//copy the chain, a bucket of the new table only receives nodes from this bucket so it needs no lock
+			while (node != nullptr) {
+				Node* next = node->next.load();
+				size_t new_index = (size_t)node->hash & mask;
+
+				new_table->buckets[new_index].store(new Node(node->key, node->value, node->hash, new_table->buckets[new_index].load()));
+				moved_nodes.add(node);
+
+				node = next;
+			}
+
+			//lookups arriving from now on follow the marker to the new table
+			old_table->buckets[index].store(moved());
+		}
+
+		/// <summary>
+		/// Claim and move ranges of buckets until none are left, the thread moving the last range swaps the tables.
+		/// The nodes of each range are retired in one batch so helpers don't serialize on the reclaimer.
+		/// </summary>
+		void help_transfer(Table* old_table) {
+			Table* new_table = old_table->next.load();
+			if (new_table == nullptr) return;
+
+			EpochReclaimer::RetireList moved_nodes;
+
+			while (true) {
+				long end = old_table->transfer_index.fetch_sub(TRANSFER_STRIDE);
+				if (end <= 0) return;
+
+				long begin = end > TRANSFER_STRIDE ? end - TRANSFER_STRIDE : 0;
+
+				for (long i = begin; i < end; i++) {
+					this->transfer_bucket(old_table, new_table, (size_t)i, moved_nodes);
+				}
+
+				this->reclaimer.retire(moved_nodes);
+
+				long done = old_table->transfer_done.fetch_add(end - begin) + (end - begin);
+
+				if (done == (long)old_table->size) {
+					this->table.store(new_table);
+					this->reclaimer.retire(old_table);
+					return;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Start growing the table if it is over its load factor and not already growing.
+		/// </summary>
+		void grow_if_needed(Table* current) {
+			if (this->count.load() <= current->size * MAX_LOAD_FACTOR) return;
+			if (this->table.load() != current || current->next.load() != nullptr) return;
+
+			Table* new_table = new Table(current->size * 2);
+			Table* expected = nullptr;
+
+			//another thread may have started the resize first
+			if (!current->next.compare_exchange_strong(expected, new_table)) {
+				delete new_table;
+			}
+
+			this->help_transfer(current);
+		}
+
+		/// <summary>
+		/// Lock the bucket of a key in the newest table holding it, helping any resize in progress.
+		/// </summary>
+		/// <returns>The table and bucket index which were locked.</returns>
+		std::unique_lock<std::mutex> lock_bucket(unsigned long long hash, Table*& current, size_t& index) {
+			current = this->table.load();
+
+			while (true) {
+				if (current->next.load() != nullptr) this->help_transfer(current);
+
+				index = (size_t)hash & (current->size - 1);
+				std::unique_lock<std::mutex> lock(current->lock_for(index));
+
+				//the bucket moved before we got the lock, continue in the next table
+				if (current->buckets[index].load() == moved()) {
+					lock.unlock();
+					current = current->next.load();
+					continue;
+				}
+
+				return lock;
+			}
+		}
+
+	public:
+		/// <summary>
+		/// Create a ConcurrentHashTable.
+		/// </summary>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		/// <param name="size">Expected number of entries.</param>
+		ConcurrentHashTable(HASH_FUNC hashing_function, unsigned long size = 128) {
+			this->hash_function = hashing_function;
+
+			//round the bucket count up to a power of two large enough for size entries
+			size_t buckets = 16;
+			while (buckets * MAX_LOAD_FACTOR < size) {
+				buckets *= 2;
+			}
+
+			table.store(new Table(buckets));
+		}
+
+		ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+		ConcurrentHashTable& operator= (const ConcurrentHashTable&) = delete;
+
+		~ConcurrentHashTable() {
+			Table* current = this->table.load();
+
+			for (size_t i = 0; i < current->size; i++) {
+				Node* node = current->buckets[i].load();
+
+				while (node != nullptr) {
+					Node* next = node->next.load();
+					delete node;
+					node = next;
+				}
+			}
+
+			delete current;
+		}
+
+		/// <summary>
+		/// Insert a value, replacing the value of an existing key.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		void insert(const KT key, VT value) {
+			EpochReclaimer::Guard guard(this->reclaimer);
+
+			unsigned long long hash = this->full_hash(key);
+			Table* current;
+			size_t index;
+			bool added = false;
+
+			{
+				auto lock = this->lock_bucket(hash, current, index);
+
+				std::atomic<Node*>* link = &current->buckets[index];
+				Node* node = link->load();
+
+				while (node != nullptr && !(node->hash == hash && node->key == key)) {
+					link = &node->next;
+					node = link->load();
+				}
+
+				if (node != nullptr) {
+					//replace the node so lookups never see a half written value
+					link->store(new Node(key, value, hash, node->next.load()));
+					this->reclaimer.retire(node);
+				}
+				else {
+					current->buckets[index].store(new Node(key, value, hash, current->buckets[index].load()));
+					added = true;
+				}
+			}
+
+			if (added) {
+				this->count.fetch_add(1);
+				this->grow_if_needed(current);
+			}
+		}
+
+		/// <summary>
+		/// Get a copy of the value stored by a given key, never blocks.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>The value, empty if the key is not in the table.</returns>
+		std::optional<VT> get(KT key) {
+			EpochReclaimer::Guard guard(this->reclaimer);
+
+			unsigned long long hash = this->full_hash(key);
+			Table* current = this->table.load();
+
+			while (true) {
+				Node* node = current->buckets[(size_t)hash & (current->size - 1)].load();
+
+				//the bucket moved to the next table
+				if (node == moved()) {
+					current = current->next.load();
+					continue;
+				}
+
+				for (; node != nullptr; node = node->next.load()) {
+					if (node->hash == hash && node->key == key) {
+						return node->value;
+					}
+				}
+
+				return std::nullopt;
+			}
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the table.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			EpochReclaimer::Guard guard(this->reclaimer);
+
+			unsigned long long hash = this->full_hash(key);
+			Table* current;
+			size_t index;
+
+			auto lock = this->lock_bucket(hash, current, index);
+
+			std::atomic<Node*>* link = &current->buckets[index];
+			Node* node = link->load();
+
+			while (node != nullptr && !(node->hash == hash && node->key == key)) {
+				link = &node->next;
+				node = link->load();
+			}
+
+			if (node == nullptr) return false;
+
+			//lookups already on the node can still follow its next link until it is reclaimed
+			link->store(node->next.load());
+			this->reclaimer.retire(node);
+			this->count.fetch_sub(1);
+
+			return true;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->count.load();
+		}
+
+		/// <summary>
+		/// Return the number of buckets in the current table.
+		/// </summary>
+		unsigned long bucket_count() const {
+			return (unsigned long)this->table.load()->size;
+		}
+	};
+};
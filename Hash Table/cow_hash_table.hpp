@@ -0,0 +1,273 @@
+#pragma once
+
+#include <atomic>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// A Hash Table whose buckets are grouped into reference counted blocks shared between copies.
+	/// The blocks are the leaves of a tree of 64 way branches, so snapshot() (and copying) only shares the root,
+	/// and a later write copies just the branches on the path to the block it touches and that block.
+	/// Each instance must only be used by one thread at a time, but snapshots may be handed to other threads.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class CowHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+		typedef typename HashTable<KT, VT>::HashEntry HashEntry;
+
+		/// <summary>
+		/// Number of buckets in a block, and of children in a branch.
+		/// </summary>
+		static constexpr unsigned long BLOCK_SIZE = 64;
+
+	private:
+		static constexpr unsigned int BLOCK_BITS = 6;
+		static_assert((1ul << BLOCK_BITS) == BLOCK_SIZE, "BLOCK_BITS must match BLOCK_SIZE");
+
+		/// <summary>
+		/// A node of the tree, shared by every parent (or table root) pointing to it.
+		/// </summary>
+		struct Node {
+			//number of parents pointing to the node, it may only be written while this is 1.
+			//an owner which sees 1 with an acquire load also sees every read made by owners which released it
+			std::atomic<unsigned long> owners{ 1 };
+		};
+
+		/// <summary>
+		/// A group of buckets which is shared until one of its buckets is written.
+		/// </summary>
+		struct Block : Node {
+			HashEntry* entries[BLOCK_SIZE] = {};
+
+			Block() {}
+
+			Block(const Block&) = delete;
+			Block& operator= (const Block&) = delete;
+
+			~Block() {
+				for (unsigned long i = 0; i < BLOCK_SIZE; i++) {
+					delete this->entries[i];
+				}
+			}
+
+			/// <summary>
+			/// Deep copy every bucket of this block.
+			/// </summary>
+			Block* copy() const {
+				Block* block = new Block();
+
+				for (unsigned long i = 0; i < BLOCK_SIZE; i++) {
+					block->entries[i] = this->entries[i] == nullptr ? nullptr : this->entries[i]->copy();
+				}
+
+				return block;
+			}
+		};
+
+		/// <summary>
+		/// An interior node, its children are branches one level down or blocks at level 1.
+		/// </summary>
+		struct Branch : Node {
+			Node* children[BLOCK_SIZE] = {};
+
+			Branch() {}
+
+			Branch(const Branch&) = delete;
+			Branch& operator= (const Branch&) = delete;
+
+			/// <summary>
+			/// Copy this branch, sharing its children with it.
+			/// </summary>
+			Branch* copy() const {
+				Branch* branch = new Branch();
+
+				for (unsigned long i = 0; i < BLOCK_SIZE; i++) {
+					branch->children[i] = this->children[i];
+					if (branch->children[i] != nullptr) branch->children[i]->owners.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				return branch;
+			}
+		};
+
+		//root of the tree, a block when depth is 0, nullptr while the table is empty
+		Node* root = nullptr;
+
+		//number of branch levels above the blocks
+		unsigned int depth = 0;
+
+		//table values
+		unsigned long table_size;
+		unsigned long count = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		/// <summary>
+		/// Drop one owner of a node at a level of the tree, freeing it and releasing its children once it has none.
+		/// </summary>
+		static void release(Node* node, unsigned int level) {
+			if (node == nullptr || node->owners.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+			if (level == 0) {
+				delete static_cast<Block*>(node);
+				return;
+			}
+
+			Branch* branch = static_cast<Branch*>(node);
+
+			for (unsigned long i = 0; i < BLOCK_SIZE; i++) {
+				release(branch->children[i], level - 1);
+			}
+
+			delete branch;
+		}
+
+		/// <summary>
+		/// Get the child index on the path to a block at a level of the tree.
+		/// </summary>
+		static unsigned long child_index(unsigned long block, unsigned int level) {
+			return (block >> (BLOCK_BITS * (level - 1))) & (BLOCK_SIZE - 1);
+		}
+
+		/// <summary>
+		/// Get the entry of a bucket for reading.
+		/// </summary>
+		HashEntry* read_entry(unsigned long index) const {
+			unsigned long block = index / BLOCK_SIZE;
+			const Node* node = this->root;
+
+			for (unsigned int level = this->depth; level > 0 && node != nullptr; level--) {
+				node = static_cast<const Branch*>(node)->children[child_index(block, level)];
+			}
+
+			return node == nullptr ? nullptr : static_cast<const Block*>(node)->entries[index % BLOCK_SIZE];
+		}
+
+		/// <summary>
+		/// Get the entry slot of a bucket for writing, copying every node on its path which is shared.
+		/// </summary>
+		HashEntry*& write_entry(unsigned long index) {
+			unsigned long block = index / BLOCK_SIZE;
+			Node** link = &this->root;
+
+			for (unsigned int level = this->depth;; level--) {
+				Node* node = *link;
+
+				if (node == nullptr) {
+					node = level == 0 ? (Node*)new Block() : (Node*)new Branch();
+				}
+				else if (node->owners.load(std::memory_order_acquire) > 1) {
+					//the copy takes our share of the node's children, then we give up our share of the node
+					node = level == 0 ? (Node*)static_cast<Block*>(node)->copy() : (Node*)static_cast<Branch*>(node)->copy();
+					release(*link, level);
+				}
+
+				*link = node;
+
+				if (level == 0) return static_cast<Block*>(node)->entries[index % BLOCK_SIZE];
+
+				link = &static_cast<Branch*>(node)->children[child_index(block, level)];
+			}
+		}
+
+	public:
+		//constructor
+		CowHashTable(HASH_FUNC hashing_function, unsigned long size = 128) {
+			this->hash_function = hashing_function;
+			this->table_size = size;
+
+			//add branch levels until the tree has a block for every bucket
+			unsigned long blocks = (this->table_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+			for (unsigned long reach = 1; reach < blocks; reach *= BLOCK_SIZE) {
+				this->depth++;
+			}
+		}
+
+		CowHashTable(const CowHashTable& other) {
+			this->root = other.root;
+			this->depth = other.depth;
+			this->table_size = other.table_size;
+			this->count = other.count;
+			this->hash_function = other.hash_function;
+
+			if (this->root != nullptr) this->root->owners.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		CowHashTable& operator= (const CowHashTable& other) {
+			if (this == &other) return *this;
+
+			if (other.root != nullptr) other.root->owners.fetch_add(1, std::memory_order_relaxed);
+			release(this->root, this->depth);
+
+			this->root = other.root;
+			this->depth = other.depth;
+			this->table_size = other.table_size;
+			this->count = other.count;
+			this->hash_function = other.hash_function;
+
+			return *this;
+		}
+
+		~CowHashTable() {
+			release(this->root, this->depth);
+		}
+
+		/// <summary>
+		/// Return a snapshot of the table in O(1), later writes to either table are not seen by the other.
+		/// </summary>
+		/// <returns>A table sharing all of this table's buckets.</returns>
+		CowHashTable snapshot() const {
+			return *this;
+		}
+
+		//insert a key value pair into the table
+		void insert(const KT key, VT value) {
+			HashEntry*& entry = this->write_entry(this->hash_function(key, this->table_size));
+
+			if (entry == nullptr) {
+				entry = new HashEntry;
+			}
+
+			entry->push(key, value);
+			this->count++;
+		}
+
+		//get a pointer to a value by providing a key, the value may be shared with snapshots so it is read only
+		const VT* get(KT key) const {
+			HashEntry* entry = this->read_entry(this->hash_function(key, this->table_size));
+
+			return entry == nullptr ? nullptr : entry->get(key);
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the table.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			unsigned long index = this->hash_function(key, this->table_size);
+
+			//check before writing so that a missing key never copies a block
+			HashEntry* entry = this->read_entry(index);
+			if (entry == nullptr || entry->get(key) == nullptr) return false;
+
+			this->write_entry(index)->remove(key);
+			this->count--;
+
+			return true;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->count;
+		}
+	};
+};
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <climits>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// A bucketized cuckoo Hash Table, every key lives in one of two buckets of four slots each.
+	/// The one byte tags of a bucket are kept apart from its keys and values, so a lookup reads the tags of both buckets
+	/// (one cache line each) and only touches the slot whose tag matches. Keys which can't be placed go to a stash of at most
+	/// STASH_SIZE items, which is empty in practice, and the table grows once the stash is full.
+	/// At most 2 * SLOTS_PER_BUCKET + STASH_SIZE keys can share a full hash, insert() rejects any more of them.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class CuckooHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+		/// <summary>
+		/// Number of slots in a bucket.
+		/// </summary>
+		static constexpr int SLOTS_PER_BUCKET = 4;
+
+		/// <summary>
+		/// Number of items which may be stored in the stash before the table grows.
+		/// </summary>
+		static constexpr size_t STASH_SIZE = 4;
+
+	private:
+		//number of displacements tried before an item is moved to the stash
+		static constexpr int MAX_KICKS = 500;
+
+		//number of doublings tried by a single grow before the insert is rejected,
+		//more than one failing means the keys share their buckets and a bigger array would not help
+		static constexpr int MAX_GROW_ATTEMPTS = 3;
+
+		/// <summary>
+		/// A Key/Value pair stored in a slot or in the stash.
+		/// </summary>
+		struct Slot {
+			KT key;
+			VT value;
+		};
+
+		/// <summary>
+		/// The hash information of a key.
+		/// </summary>
+		struct Hashed {
+			size_t index;
+			unsigned char tag;
+		};
+
+		//one byte of each slot's hash, SLOTS_PER_BUCKET per bucket, 0 marks an empty slot
+		unsigned char* tags;
+
+		//keys and values of the slots, in the same order as the tags
+		Slot* slots;
+
+		//number of buckets, always a power of two
+		size_t bucket_count;
+
+		//items which could not be placed in a bucket
+		std::vector<Slot> stash;
+
+		//number of Key/Value pairs stored
+		unsigned long count = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		//state of the random number generator used to pick eviction victims
+		unsigned long long random_state = 0x2545F4914F6CDD1Dull;
+
+		/// <summary>
+		/// Get the primary bucket and tag of a key.
+		/// </summary>
+		Hashed hash_key(const KT& key) const {
+			unsigned long long hash = mix_hash(this->hash_function(key, ULONG_MAX));
+			unsigned char tag = (unsigned char)(hash >> 56);
+
+			return Hashed{ (size_t)hash & (this->bucket_count - 1), tag == 0 ? (unsigned char)1 : tag };
+		}
+
+		/// <summary>
+		/// Get the other bucket of an item from one of its buckets and its tag, without needing the key.
+		/// </summary>
+		size_t alt_index(size_t index, unsigned char tag) const {
+			return (index ^ (size_t)mix_hash(tag)) & (this->bucket_count - 1);
+		}
+
+		/// <summary>
+		/// Return the next pseudo random number (xorshift64).
+		/// </summary>
+		unsigned long long next_random() {
+			this->random_state ^= this->random_state << 13;
+			this->random_state ^= this->random_state >> 7;
+			this->random_state ^= this->random_state << 17;
+
+			return this->random_state;
+		}
+
+		/// <summary>
+		/// Allocate an empty bucket array.
+		/// </summary>
+		void allocate(size_t new_count) {
+			this->tags = new unsigned char[new_count * SLOTS_PER_BUCKET]();
+			this->slots = new Slot[new_count * SLOTS_PER_BUCKET];
+			this->bucket_count = new_count;
+		}
+
+		/// <summary>
+		/// Find the slot of a key in a single bucket.
+		/// </summary>
+		/// <returns>Index of the slot, -1 if the key is not in the bucket.</returns>
+		long long find_in_bucket(size_t index, unsigned char tag, const KT& key) const {
+			size_t first = index * SLOTS_PER_BUCKET;
+
+			for (size_t i = first; i < first + SLOTS_PER_BUCKET; i++) {
+				if (this->tags[i] == tag && this->slots[i].key == key) {
+					return (long long)i;
+				}
+			}
+
+			return -1;
+		}
+
+		/// <summary>
+		/// Find the value of a key given its hash information.
+		/// </summary>
+		VT* find(const KT& key, Hashed hashed) {
+			long long slot = this->find_in_bucket(hashed.index, hashed.tag, key);
+			if (slot < 0) slot = this->find_in_bucket(this->alt_index(hashed.index, hashed.tag), hashed.tag, key);
+			if (slot >= 0) return &this->slots[slot].value;
+
+			for (auto& item : this->stash) {
+				if (item.key == key) return &item.value;
+			}
+
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Move an item into a free slot of a bucket.
+		/// </summary>
+		/// <returns>If the bucket had a free slot.</returns>
+		bool try_bucket(size_t index, KT& key, VT& value, unsigned char tag) {
+			size_t first = index * SLOTS_PER_BUCKET;
+
+			for (size_t i = first; i < first + SLOTS_PER_BUCKET; i++) {
+				if (this->tags[i] == 0) {
+					this->tags[i] = tag;
+					this->slots[i].key = std::move(key);
+					this->slots[i].value = std::move(value);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Place an item in one of its buckets, displacing other items along a bounded path if both are full.
+		/// If no free slot is found the last displaced item is left in key, value and tag.
+		/// </summary>
+		/// <param name="path">If not nullptr, receives the MAX_KICKS slots swapped on a failed placement so it can be undone.</param>
+		/// <returns>If every item found a slot.</returns>
+		bool place(KT& key, VT& value, unsigned char& tag, size_t index, size_t* path = nullptr) {
+			if (this->try_bucket(index, key, value, tag)) return true;
+
+			index = this->alt_index(index, tag);
+			if (this->try_bucket(index, key, value, tag)) return true;
+
+			for (int kick = 0; kick < MAX_KICKS; kick++) {
+				//swap the item with a random victim, the victim then moves to its other bucket
+				size_t slot = index * SLOTS_PER_BUCKET + (size_t)(this->next_random() % SLOTS_PER_BUCKET);
+				if (path != nullptr) path[kick] = slot;
+
+				this->swap_slot(slot, key, value, tag);
+
+				index = this->alt_index(index, tag);
+				if (this->try_bucket(index, key, value, tag)) return true;
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Swap an item with the one in a slot.
+		/// </summary>
+		void swap_slot(size_t slot, KT& key, VT& value, unsigned char& tag) {
+			std::swap(tag, this->tags[slot]);
+			std::swap(key, this->slots[slot].key);
+			std::swap(value, this->slots[slot].value);
+		}
+
+		/// <summary>
+		/// Move every item and one homeless item into a bucket array of double the size,
+		/// doubling again a bounded number of times if the items still overflow the stash.
+		/// </summary>
+		/// <returns>If every item was placed, the table is left unchanged otherwise.</returns>
+		bool grow(Slot& homeless) {
+			//the old arrays stay intact until a rebuild succeeds, so only point at their items
+			std::vector<const Slot*> items;
+			items.reserve(this->count + 1);
+
+			for (size_t i = 0; i < this->bucket_count * SLOTS_PER_BUCKET; i++) {
+				if (this->tags[i] != 0) items.push_back(&this->slots[i]);
+			}
+
+			for (auto& item : this->stash) {
+				items.push_back(&item);
+			}
+
+			items.push_back(&homeless);
+
+			size_t new_count = this->bucket_count * 2;
+
+			for (int attempt = 0; attempt < MAX_GROW_ATTEMPTS; attempt++) {
+				if (this->rebuild(items, new_count)) return true;
+
+				new_count *= 2;
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Try to copy a list of items into a new bucket array of a given size.
+		/// </summary>
+		/// <returns>If every item was placed, the table is left unchanged otherwise.</returns>
+		bool rebuild(const std::vector<const Slot*>& items, size_t new_count) {
+			unsigned char* old_tags = this->tags;
+			Slot* old_slots = this->slots;
+			size_t old_count = this->bucket_count;
+			std::vector<Slot> old_stash = std::move(this->stash);
+
+			this->allocate(new_count);
+			this->stash.clear();
+
+			for (auto item : items) {
+				KT key = item->key;
+				VT value = item->value;
+				Hashed hashed = this->hash_key(key);
+
+				if (this->place(key, value, hashed.tag, hashed.index)) continue;
+
+				if (this->stash.size() < STASH_SIZE) {
+					this->stash.push_back(Slot{ std::move(key), std::move(value) });
+					continue;
+				}
+
+				//the new array is too small, restore the old one
+				delete[] this->tags;
+				delete[] this->slots;
+				this->tags = old_tags;
+				this->slots = old_slots;
+				this->bucket_count = old_count;
+				this->stash = std::move(old_stash);
+				return false;
+			}
+
+			delete[] old_tags;
+			delete[] old_slots;
+			return true;
+		}
+
+	public:
+		/// <summary>
+		/// Create a CuckooHashTable.
+		/// </summary>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		/// <param name="size">Expected number of entries.</param>
+		CuckooHashTable(HASH_FUNC hashing_function, unsigned long size = 128) {
+			this->hash_function = hashing_function;
+
+			//round the bucket count up to a power of two
+			size_t new_count = 1;
+			while (new_count * SLOTS_PER_BUCKET < size) {
+				new_count *= 2;
+			}
+
+			this->allocate(new_count);
+		}
+
+		CuckooHashTable(const CuckooHashTable&) = delete;
+		CuckooHashTable& operator= (const CuckooHashTable&) = delete;
+
+		~CuckooHashTable() {
+			delete[] this->tags;
+			delete[] this->slots;
+		}
+
+		/// <summary>
+		/// Insert a value, replacing the value of an existing key.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		/// <returns>False if the key shares its full hash with too many other keys to be placed, the table is unchanged then.</returns>
+		bool insert(const KT key, VT value) {
+			Hashed hashed = this->hash_key(key);
+
+			VT* existing = this->find(key, hashed);
+			if (existing != nullptr) {
+				*existing = std::move(value);
+				return true;
+			}
+
+			Slot homeless{ key, std::move(value) };
+			unsigned char tag = hashed.tag;
+			size_t path[MAX_KICKS];
+
+			if (!this->place(homeless.key, homeless.value, tag, hashed.index, path)) {
+				//keep the item left without a slot in the stash while there is room, otherwise grow with it
+				if (this->stash.size() < STASH_SIZE) {
+					this->stash.push_back(std::move(homeless));
+				}
+				else if (!this->grow(homeless)) {
+					//swap the displaced items back in reverse, which leaves the table as it was before the insert
+					for (int kick = MAX_KICKS - 1; kick >= 0; kick--) {
+						this->swap_slot(path[kick], homeless.key, homeless.value, tag);
+					}
+
+					return false;
+				}
+			}
+
+			this->count++;
+			return true;
+		}
+
+		/// <summary>
+		/// Get a pointer to the value stored by a given key.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>Pointer to the value, nullptr if the key is not in the table.</returns>
+		VT* get(KT key) {
+			return this->find(key, this->hash_key(key));
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the table.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			Hashed hashed = this->hash_key(key);
+
+			long long slot = this->find_in_bucket(hashed.index, hashed.tag, key);
+			if (slot < 0) slot = this->find_in_bucket(this->alt_index(hashed.index, hashed.tag), hashed.tag, key);
+
+			if (slot >= 0) {
+				//reset the slot so the removed key and value release their memory
+				this->tags[slot] = 0;
+				this->slots[slot].key = KT();
+				this->slots[slot].value = VT();
+
+				this->count--;
+				return true;
+			}
+
+			for (size_t i = 0; i < this->stash.size(); i++) {
+				if (this->stash[i].key == key) {
+					this->stash.erase(this->stash.begin() + i);
+
+					this->count--;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Return the fraction of slots which are in use.
+		/// </summary>
+		double load_factor() const {
+			return (double)this->count / (double)(this->bucket_count * SLOTS_PER_BUCKET);
+		}
+
+		/// <summary>
+		/// Return the number of items in the stash, never more than STASH_SIZE.
+		/// </summary>
+		size_t stash_size() const {
+			return this->stash.size();
+		}
+	};
+};
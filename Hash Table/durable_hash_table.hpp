@@ -0,0 +1,684 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <type_traits>
+#include <filesystem>
+#include <chrono>
+#include "hash_table.hpp"
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace hash_table {
+	/// <summary>
+	/// Append a key or value to a log record, overload this together with read_log_value for types which aren't trivially copyable.
+	/// </summary>
+	template <typename T>
+	void write_log_value(std::string& out, const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "overload write_log_value and read_log_value for this type");
+
+		out.append((const char*)&value, sizeof(T));
+	}
+
+	/// <summary>
+	/// Read a key or value written by write_log_value, returns false if the record is too short.
+	/// </summary>
+	template <typename T>
+	bool read_log_value(const char*& data, const char* end, T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "overload write_log_value and read_log_value for this type");
+
+		if ((size_t)(end - data) < sizeof(T)) return false;
+
+		std::memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+
+		return true;
+	}
+
+	/// <summary>
+	/// Append a string to a log record as its length followed by its characters.
+	/// </summary>
+	template <typename CharT, typename Traits, typename StringAllocator>
+	void write_log_value(std::string& out, const std::basic_string<CharT, Traits, StringAllocator>& text) {
+		uint64_t length = text.length();
+
+		write_log_value(out, length);
+		out.append((const char*)text.data(), text.length() * sizeof(CharT));
+	}
+
+	/// <summary>
+	/// Read a string written by write_log_value, returns false if the record is too short.
+	/// </summary>
+	template <typename CharT, typename Traits, typename StringAllocator>
+	bool read_log_value(const char*& data, const char* end, std::basic_string<CharT, Traits, StringAllocator>& text) {
+		uint64_t length;
+
+		if (!read_log_value(data, end, length) || length > (uint64_t)(end - data) / sizeof(CharT)) return false;
+
+		//copy rather than cast since the characters may not be aligned in the record
+		text.resize((size_t)length);
+		std::memcpy(text.data(), data, (size_t)length * sizeof(CharT));
+		data += (size_t)length * sizeof(CharT);
+
+		return true;
+	}
+
+	/// <summary>
+	/// A binary file opened for reading and appending, with an explicit sync to stable storage.
+	/// </summary>
+	class LogFile
+	{
+	private:
+		//file descriptor, -1 when closed
+		int fd = -1;
+
+	public:
+		LogFile() {}
+
+		LogFile(const LogFile&) = delete;
+		LogFile& operator= (const LogFile&) = delete;
+
+		~LogFile() {
+			this->close();
+		}
+
+		/// <summary>
+		/// Open a file, creating it if it doesn't exist.
+		/// </summary>
+		bool open(const std::string& path) {
+			this->close();
+
+#if defined(_WIN32)
+			this->fd = _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+			this->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+#endif
+
+			return this->fd >= 0;
+		}
+
+		/// <summary>
+		/// Check if the file is open.
+		/// </summary>
+		bool is_open() const {
+			return this->fd >= 0;
+		}
+
+		/// <summary>
+		/// Close the file.
+		/// </summary>
+		void close() {
+			if (this->fd < 0) return;
+
+#if defined(_WIN32)
+			_close(this->fd);
+#else
+			::close(this->fd);
+#endif
+
+			this->fd = -1;
+		}
+
+		/// <summary>
+		/// Get the length of the file.
+		/// </summary>
+		bool size(uint64_t& length) {
+#if defined(_WIN32)
+			long long end = _lseeki64(this->fd, 0, SEEK_END);
+#else
+			off_t end = lseek(this->fd, 0, SEEK_END);
+#endif
+			if (end < 0) return false;
+
+			length = (uint64_t)end;
+			return true;
+		}
+
+		/// <summary>
+		/// Move the read position to an offset from the start of the file.
+		/// </summary>
+		bool seek(uint64_t offset) {
+#if defined(_WIN32)
+			return _lseeki64(this->fd, (long long)offset, SEEK_SET) >= 0;
+#else
+			return lseek(this->fd, (off_t)offset, SEEK_SET) >= 0;
+#endif
+		}
+
+		/// <summary>
+		/// Read bytes from the read position, fewer than length are only returned at the end of the file.
+		/// </summary>
+		/// <returns>Number of bytes read, -1 if the read failed.</returns>
+		long long read(char* data, size_t length) {
+			size_t total = 0;
+
+			//reads may be partial, keep going until the buffer is full or the file ends
+			while (total < length) {
+#if defined(_WIN32)
+				int count = _read(this->fd, data + total, length - total > INT_MAX ? INT_MAX : (unsigned int)(length - total));
+#else
+				ssize_t count = ::read(this->fd, data + total, length - total);
+#endif
+				if (count < 0) return -1;
+				if (count == 0) break;
+
+				total += (size_t)count;
+			}
+
+			return (long long)total;
+		}
+
+		/// <summary>
+		/// Write bytes to the end of the file.
+		/// </summary>
+		bool append(const char* data, size_t length) {
+#if defined(_WIN32)
+			if (_lseeki64(this->fd, 0, SEEK_END) < 0) return false;
+#else
+			if (lseek(this->fd, 0, SEEK_END) < 0) return false;
+#endif
+
+			//writes may be partial, keep going until everything is written
+			while (length > 0) {
+#if defined(_WIN32)
+				int written = _write(this->fd, data, length > INT_MAX ? INT_MAX : (unsigned int)length);
+#else
+				ssize_t written = ::write(this->fd, data, length);
+#endif
+				if (written <= 0) return false;
+
+				data += written;
+				length -= (size_t)written;
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Flush written bytes to stable storage.
+		/// </summary>
+		bool sync() {
+#if defined(_WIN32)
+			return _commit(this->fd) == 0;
+#else
+			return fsync(this->fd) == 0;
+#endif
+		}
+
+		/// <summary>
+		/// Cut the file to a length.
+		/// </summary>
+		bool truncate(uint64_t length) {
+#if defined(_WIN32)
+			return _chsize_s(this->fd, (long long)length) == 0;
+#else
+			return ftruncate(this->fd, (off_t)length) == 0;
+#endif
+		}
+
+		/// <summary>
+		/// Flush the directory holding a file so that a rename into it is durable (nothing to do on windows).
+		/// </summary>
+		static bool sync_directory(const std::string& path) {
+#if defined(_WIN32)
+			return true;
+#else
+			std::string directory = std::filesystem::path(path).parent_path().string();
+			int directory_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_CLOEXEC);
+			if (directory_fd < 0) return false;
+
+			bool synced = fsync(directory_fd) == 0;
+			::close(directory_fd);
+
+			return synced;
+#endif
+		}
+	};
+
+	/// <summary>
+	/// A HashTable whose inserts and removes are appended to a write-ahead log, so its contents survive a crash.
+	/// Log records are buffered and written with a single fsync per group of operations (group commit), a group is also
+	/// committed by the first operation after its oldest record has waited commit_interval. Only operations made after the last
+	/// commit can be lost, and nothing commits a quiet table, so call commit() before acknowledging a write which must be durable.
+	/// On startup the snapshot and then the log are replayed, a torn record at the end of the log (from a crash mid-write) is cut off.
+	/// If the files can't be recovered (an unreadable or damaged snapshot, or a log path holding another file) the table is left
+	/// empty and closed, and every write is rejected.
+	/// compact() folds the log into a new snapshot, which also happens automatically once the log grows past a size.
+	/// Files are written in the native byte order and wchar_t size, so they can't be moved between platforms.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class DurableHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+	private:
+		//file headers, a magic value followed by the generation of the file
+		static constexpr char LOG_MAGIC[8] = { 'H', 'T', 'W', 'A', 'L', '0', '0', '1' };
+		static constexpr char SNAPSHOT_MAGIC[8] = { 'H', 'T', 'S', 'N', 'A', 'P', '0', '1' };
+		static constexpr size_t HEADER_SIZE = 16;
+
+		//every record starts with its payload length and checksum
+		static constexpr size_t RECORD_HEADER_SIZE = 8;
+
+		//bytes of snapshot buffered before they are written
+		static constexpr size_t SNAPSHOT_BUFFER = 1024 * 1024;
+
+		//bytes read at a time while replaying a file
+		static constexpr size_t REPLAY_BLOCK = 64 * 1024;
+
+		//table holding the current contents
+		HashTable<KT, VT> table;
+
+		//log and snapshot paths
+		std::string log_path;
+		std::string snapshot_path;
+
+		//open log file
+		LogFile log;
+
+		//generation of the log, a snapshot of generation N contains everything in the logs before N
+		uint64_t generation = 0;
+
+		//records which haven't been committed yet, and when the oldest of them was logged
+		std::string pending;
+		unsigned long pending_count = 0;
+		std::chrono::steady_clock::time_point pending_since;
+
+		//operations per group commit, and the longest a record waits for a later operation to commit it
+		unsigned long group_size;
+		std::chrono::milliseconds commit_interval;
+
+		//bytes in the log file and the size past which it is compacted, 0 never compacts automatically
+		uint64_t log_bytes = 0;
+		uint64_t compact_bytes;
+
+		//bytes in the last snapshot, the log must also outgrow it before it is compacted again
+		uint64_t snapshot_bytes = 0;
+
+		/// <summary>
+		/// Checksum of a record payload.
+		/// </summary>
+		static uint32_t checksum(const char* data, size_t length) {
+			//fnv-1a over eight bytes at a time, the bytes of the last word are mixed in one by one
+			uint64_t hash = 0xCBF29CE484222325ull ^ length;
+			size_t i = 0;
+
+			for (; i + 8 <= length; i += 8) {
+				uint64_t word;
+				std::memcpy(&word, data + i, sizeof(word));
+
+				hash ^= word;
+				hash *= 0x100000001B3ull;
+				hash ^= hash >> 32;
+			}
+
+			for (; i < length; i++) {
+				hash ^= (unsigned char)data[i];
+				hash *= 0x100000001B3ull;
+			}
+
+			return (uint32_t)mix_hash(hash);
+		}
+
+		/// <summary>
+		/// Build a file header.
+		/// </summary>
+		static std::string header(const char magic[8], uint64_t generation) {
+			std::string out(magic, 8);
+			write_log_value(out, generation);
+
+			return out;
+		}
+
+		/// <summary>
+		/// Read a file header, returns false if the file doesn't start with the magic value.
+		/// </summary>
+		static bool read_header(LogFile& file, const char magic[8], uint64_t& generation) {
+			char data[HEADER_SIZE];
+
+			if (!file.seek(0) || file.read(data, HEADER_SIZE) != (long long)HEADER_SIZE || std::memcmp(data, magic, 8) != 0) return false;
+
+			const char* cursor = data + 8;
+			return read_log_value(cursor, data + HEADER_SIZE, generation);
+		}
+
+		/// <summary>
+		/// Append an insert ('I') or remove ('R') record.
+		/// </summary>
+		static void write_record(std::string& out, char operation, const KT& key, const VT* value) {
+			size_t start = out.size();
+
+			//reserve the record header, it is filled in once the payload length is known
+			out.append(RECORD_HEADER_SIZE, '\0');
+			out.push_back(operation);
+
+			write_log_value(out, key);
+			if (value != nullptr) write_log_value(out, *value);
+
+			uint32_t length = (uint32_t)(out.size() - start - RECORD_HEADER_SIZE);
+			uint32_t sum = checksum(out.data() + start + RECORD_HEADER_SIZE, length);
+
+			std::memcpy(&out[start], &length, sizeof(length));
+			std::memcpy(&out[start + sizeof(length)], &sum, sizeof(sum));
+		}
+
+		/// <summary>
+		/// Apply the records of a file to the table, stopping at the first incomplete or corrupt record.
+		/// The file is read in blocks, so only one block and the record being applied are held in memory.
+		/// </summary>
+		/// <param name="file_size">Length of the file, records claiming to run past it are treated as torn.</param>
+		/// <param name="valid">Receives the number of bytes of the file which were valid.</param>
+		/// <returns>False if the file couldn't be read.</returns>
+		bool replay(LogFile& file, uint64_t file_size, uint64_t& valid) {
+			valid = HEADER_SIZE;
+			if (!file.seek(HEADER_SIZE)) return false;
+
+			//bytes read but not yet applied start at buffer[start], which is at offset valid in the file
+			std::string buffer;
+			size_t start = 0;
+			bool ended = false;
+
+			while (true) {
+				size_t buffered = buffer.size() - start;
+				size_t needed = RECORD_HEADER_SIZE;
+				uint32_t length = 0, sum = 0;
+
+				if (buffered >= RECORD_HEADER_SIZE) {
+					std::memcpy(&length, buffer.data() + start, sizeof(length));
+					std::memcpy(&sum, buffer.data() + start + sizeof(length), sizeof(sum));
+
+					//a record cut short by a crash
+					if (length == 0 || length > file_size - valid - RECORD_HEADER_SIZE) break;
+
+					needed += length;
+				}
+
+				if (buffered < needed) {
+					if (ended) break;
+
+					//drop the applied records and read the next block, or the rest of a record longer than a block
+					buffer.erase(0, start);
+					start = 0;
+
+					size_t old_size = buffer.size();
+					size_t block = needed - buffered > REPLAY_BLOCK ? needed - buffered : REPLAY_BLOCK;
+					buffer.resize(old_size + block);
+
+					long long count = file.read(&buffer[old_size], block);
+					if (count < 0) return false;
+
+					buffer.resize(old_size + (size_t)count);
+					ended = (size_t)count < block;
+					continue;
+				}
+
+				const char* payload = buffer.data() + start + RECORD_HEADER_SIZE;
+				const char* end = payload + length;
+				const char* cursor = payload + 1;
+
+				if (checksum(payload, length) != sum) break;
+
+				KT key;
+				if (!read_log_value(cursor, end, key)) break;
+
+				if (*payload == 'I') {
+					VT value;
+					if (!read_log_value(cursor, end, value)) break;
+
+					this->table.insert(key, value);
+				}
+				else if (*payload == 'R') {
+					this->table.remove(key);
+				}
+				else {
+					break;
+				}
+
+				start += needed;
+				valid += needed;
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Empty the log and start a new generation of it.
+		/// </summary>
+		bool reset_log(uint64_t new_generation) {
+			std::string log_header = header(LOG_MAGIC, new_generation);
+
+			if (!this->log.truncate(0) || !this->log.append(log_header.data(), log_header.size()) || !this->log.sync()) return false;
+
+			this->generation = new_generation;
+			this->log_bytes = HEADER_SIZE;
+
+			return true;
+		}
+
+		/// <summary>
+		/// Load the snapshot and replay the log into the table.
+		/// </summary>
+		bool recover() {
+			uint64_t snapshot_generation = 0;
+
+			//load the snapshot if one was written
+			if (std::filesystem::exists(this->snapshot_path)) {
+				LogFile snapshot;
+				uint64_t snapshot_size, valid;
+
+				if (!snapshot.open(this->snapshot_path) || !snapshot.size(snapshot_size) || !read_header(snapshot, SNAPSHOT_MAGIC, snapshot_generation)) return false;
+
+				//a snapshot is synced before it is renamed into place, so anything short of the whole file is damage
+				if (!this->replay(snapshot, snapshot_size, valid) || valid < snapshot_size) return false;
+
+				this->snapshot_bytes = snapshot_size;
+			}
+
+			uint64_t log_size;
+			if (!this->log.open(this->log_path) || !this->log.size(log_size)) return false;
+
+			//a new log, or one whose header was torn before anything was logged
+			if (log_size < HEADER_SIZE) return this->reset_log(snapshot_generation);
+
+			uint64_t log_generation;
+			if (!read_header(this->log, LOG_MAGIC, log_generation)) {
+				//refuse to overwrite a file which isn't a log
+				this->log.close();
+				return false;
+			}
+
+			//a crash after a snapshot was written but before the log was emptied, the snapshot already holds the log
+			if (log_generation < snapshot_generation) return this->reset_log(snapshot_generation);
+
+			uint64_t valid;
+			if (!this->replay(this->log, log_size, valid)) return false;
+
+			//cut off a torn tail so new records follow the last complete one
+			if (valid < log_size && (!this->log.truncate(valid) || !this->log.sync())) return false;
+
+			this->generation = log_generation;
+			this->log_bytes = valid;
+
+			return true;
+		}
+
+		/// <summary>
+		/// Count an operation and commit once a group is full or its oldest record has waited commit_interval.
+		/// </summary>
+		void logged() {
+			auto now = std::chrono::steady_clock::now();
+			if (this->pending_count++ == 0) this->pending_since = now;
+
+			if (this->pending_count >= this->group_size || now - this->pending_since >= this->commit_interval) this->commit();
+		}
+
+	public:
+		/// <summary>
+		/// Open or create a durable table, replaying anything already logged at the path.
+		/// </summary>
+		/// <param name="hashing_function">Function used to hash keys.</param>
+		/// <param name="path">Base path, the log and snapshot are stored at path.log and path.snapshot.</param>
+		/// <param name="size">Number of table buckets.</param>
+		/// <param name="group_size">Operations buffered before they are written and synced together.</param>
+		/// <param name="compact_bytes">Log size in bytes past which a commit compacts it into a snapshot, 0 to only compact on request.</param>
+		/// <param name="commit_interval">Age of the oldest buffered record past which the next operation commits the group early.</param>
+		DurableHashTable(HASH_FUNC hashing_function, const std::string& path, unsigned long size = 128, unsigned long group_size = 1024,
+			uint64_t compact_bytes = 64 * 1024 * 1024, std::chrono::milliseconds commit_interval = std::chrono::milliseconds(100))
+			: table(hashing_function, size) {
+			this->log_path = path + ".log";
+			this->snapshot_path = path + ".snapshot";
+			this->group_size = group_size == 0 ? 1 : group_size;
+			this->commit_interval = commit_interval;
+			this->compact_bytes = compact_bytes;
+
+			if (!this->recover()) {
+				//don't serve a partial recovery, and don't buffer writes which could never be logged
+				this->log.close();
+				this->table.erase_if([](const KT&, const VT&) { return true; });
+			}
+		}
+
+		DurableHashTable(const DurableHashTable&) = delete;
+		DurableHashTable& operator= (const DurableHashTable&) = delete;
+
+		~DurableHashTable() {
+			this->commit();
+		}
+
+		/// <summary>
+		/// Check if the log was opened and recovered, writes are rejected when it wasn't.
+		/// </summary>
+		bool is_open() const {
+			return this->log.is_open();
+		}
+
+		/// <summary>
+		/// Insert a key value pair and log it. The record is buffered until group_size operations are pending,
+		/// or until an operation comes commit_interval after the oldest pending one. With no later operation it
+		/// stays buffered until commit() or the destructor, so call commit() before acknowledging a write which must be durable.
+		/// </summary>
+		/// <returns>If the pair was inserted, false if the log isn't open.</returns>
+		bool insert(const KT& key, const VT& value) {
+			if (!this->log.is_open()) return false;
+
+			this->table.insert(key, value);
+
+			write_record(this->pending, 'I', key, &value);
+			this->logged();
+
+			return true;
+		}
+
+		/// <summary>
+		/// Get a pointer to a value by providing a key.
+		/// </summary>
+		VT* get(const KT& key) {
+			return this->table.get(key);
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key and log it, the record is buffered like the one of insert().
+		/// </summary>
+		/// <returns>If the value was found and removed, false if the log isn't open.</returns>
+		bool remove(const KT& key) {
+			if (!this->log.is_open() || !this->table.remove(key)) return false;
+
+			write_record(this->pending, 'R', key, nullptr);
+			this->logged();
+
+			return true;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		unsigned long size() {
+			return this->table.size();
+		}
+
+		/// <summary>
+		/// Write every pending record to the log with a single sync.
+		/// If the write fails the log is cut back and the records are kept so a later commit can retry them.
+		/// </summary>
+		/// <returns>If every operation so far is durable.</returns>
+		bool commit() {
+			if (!this->log.is_open()) return false;
+			if (this->pending.empty()) return true;
+
+			if (!this->log.append(this->pending.data(), this->pending.size()) || !this->log.sync()) {
+				this->log.truncate(this->log_bytes);
+				return false;
+			}
+
+			this->log_bytes += this->pending.size();
+			this->pending.clear();
+			this->pending_count = 0;
+
+			//compacting only once the log outgrows the snapshot keeps the cost of snapshots proportional to the logging done
+			if (this->compact_bytes > 0 && this->log_bytes > this->compact_bytes && this->log_bytes > this->snapshot_bytes) return this->compact();
+
+			return true;
+		}
+
+		/// <summary>
+		/// Write the current contents to a new snapshot and empty the log.
+		/// The snapshot is written to a temporary file and renamed into place, so a crash leaves either the old or new snapshot.
+		/// </summary>
+		/// <returns>If the snapshot was written.</returns>
+		bool compact() {
+			if (!this->commit()) return false;
+
+			std::string temp_path = this->snapshot_path + ".tmp";
+			LogFile snapshot;
+
+			if (!snapshot.open(temp_path) || !snapshot.truncate(0)) return false;
+
+			std::string data = header(SNAPSHOT_MAGIC, this->generation + 1);
+			uint64_t written = 0;
+
+			for (unsigned long i = 0; i < this->table.table_size; i++) {
+				auto entry = this->table.table[i];
+
+				if (entry == nullptr) continue;
+
+				//inserts push to the front of a chain, so write each chain back to front to rebuild it in the same order
+				for (auto node = entry->tail; node != nullptr; node = node->front) {
+					write_record(data, 'I', node->key, &node->value);
+				}
+
+				if (data.size() >= SNAPSHOT_BUFFER) {
+					if (!snapshot.append(data.data(), data.size())) return false;
+
+					written += data.size();
+					data.clear();
+				}
+			}
+
+			if (!snapshot.append(data.data(), data.size()) || !snapshot.sync()) return false;
+			snapshot.close();
+
+			written += data.size();
+
+			std::error_code error;
+			std::filesystem::rename(temp_path, this->snapshot_path, error);
+			if (error || !LogFile::sync_directory(this->snapshot_path)) return false;
+
+			this->snapshot_bytes = written;
+
+			//the snapshot now holds this generation of the log
+			return this->reset_log(this->generation + 1);
+		}
+	};
+};
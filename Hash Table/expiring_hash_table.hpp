@@ -0,0 +1,409 @@
+#pragma once
+
+#include <chrono>
+#include <climits>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// A Hash Table whose entries can be given a time to live.
+	/// Expired entries are dropped lazily by get() and in bulk by expire(), which uses a hierarchical
+	/// timer wheel so that its cost depends on the number of entries expiring, not the size of the table.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class ExpiringHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+		typedef std::chrono::steady_clock CLOCK;
+
+		/// <summary>
+		/// Object representing a Key/Value pair and its expiration timer.
+		/// </summary>
+		struct ExpiringNode {
+			/// <summary>
+			/// Reference to the next node in the same bucket.
+			/// </summary>
+			ExpiringNode* next = nullptr;
+
+			/// <summary>
+			/// Reference to the link which points at this node in its bucket.
+			/// </summary>
+			ExpiringNode** prev_link = nullptr;
+
+			/// <summary>
+			/// Reference to the next node in the same timer wheel slot.
+			/// </summary>
+			ExpiringNode* timer_next = nullptr;
+
+			/// <summary>
+			/// Reference to the link which points at this node in its timer wheel slot, nullptr if no timer is set.
+			/// </summary>
+			ExpiringNode** timer_prev_link = nullptr;
+
+			/// <summary>
+			/// Tick at which the node expires, NEVER if it does not expire.
+			/// </summary>
+			unsigned long long expires;
+
+			/// <summary>
+			/// Key of the node.
+			/// </summary>
+			KT key;
+
+			/// <summary>
+			/// Value stored in the node.
+			/// </summary>
+			VT value;
+
+			ExpiringNode(KT key, VT value, unsigned long long expires) {
+				this->key = key;
+				this->value = value;
+				this->expires = expires;
+			}
+		};
+
+		/// <summary>
+		/// Expiration tick of entries without a time to live.
+		/// </summary>
+		static constexpr unsigned long long NEVER = ULLONG_MAX;
+
+	private:
+		//timer wheel shape, each level covers SLOT_BITS more bits of the tick count
+		static constexpr int SLOT_BITS = 6;
+		static constexpr int SLOTS = 1 << SLOT_BITS;
+		static constexpr int LEVELS = 4;
+
+		//bucket chains
+		ExpiringNode** table;
+
+		//table values
+		unsigned long table_size;
+		unsigned long count = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		//length of one tick and the time of tick 0
+		CLOCK::duration resolution;
+		CLOCK::time_point epoch;
+
+		//the last tick processed by the timer wheel
+		unsigned long long current_tick = 0;
+
+		//number of nodes with a timer set
+		unsigned long timer_count = 0;
+
+		//timer wheel slots, plus a list for timers beyond the range of the top level
+		ExpiringNode* wheel[LEVELS][SLOTS] = {};
+		ExpiringNode* far_timers = nullptr;
+
+		/// <summary>
+		/// Convert a time point into a tick count, rounding up so that entries never expire early.
+		/// </summary>
+		unsigned long long to_tick(CLOCK::time_point time) const {
+			if (time <= this->epoch) return 0;
+
+			auto elapsed = time - this->epoch;
+			return (unsigned long long)((elapsed + this->resolution - CLOCK::duration(1)) / this->resolution);
+		}
+
+		/// <summary>
+		/// Convert a time point into the last tick which has fully elapsed.
+		/// </summary>
+		unsigned long long elapsed_tick(CLOCK::time_point time) const {
+			if (time <= this->epoch) return 0;
+
+			return (unsigned long long)((time - this->epoch) / this->resolution);
+		}
+
+		/// <summary>
+		/// Find the node with the specified key.
+		/// </summary>
+		ExpiringNode* find_node(const KT& key) {
+			ExpiringNode* current_node = this->table[this->hash_function(key, this->table_size)];
+
+			while (current_node != nullptr && !(current_node->key == key)) {
+				current_node = current_node->next;
+			}
+
+			return current_node;
+		}
+
+		/// <summary>
+		/// Push a node onto an intrusive list given the list's head link.
+		/// </summary>
+		static void push_link(ExpiringNode** head, ExpiringNode* node, ExpiringNode* ExpiringNode::* next, ExpiringNode** ExpiringNode::* prev_link) {
+			node->*next = *head;
+			if (*head != nullptr) (*head)->*prev_link = &(node->*next);
+
+			node->*prev_link = head;
+			*head = node;
+		}
+
+		/// <summary>
+		/// Remove a node from an intrusive list.
+		/// </summary>
+		static void pop_link(ExpiringNode* node, ExpiringNode* ExpiringNode::* next, ExpiringNode** ExpiringNode::* prev_link) {
+			*(node->*prev_link) = node->*next;
+			if (node->*next != nullptr) (node->*next)->*prev_link = node->*prev_link;
+
+			node->*next = nullptr;
+			node->*prev_link = nullptr;
+		}
+
+		/// <summary>
+		/// Place a node's timer into the wheel slot matching its expiration tick.
+		/// </summary>
+		/// <param name="earliest">The first tick which has not been processed yet, timers already due fire then.</param>
+		void schedule(ExpiringNode* node, unsigned long long earliest) {
+			unsigned long long expires = node->expires < earliest ? earliest : node->expires;
+
+			ExpiringNode** slot = &this->far_timers;
+
+			//use the lowest level whose parent block contains both the current tick and the expiration tick
+			for (int level = 0; level < LEVELS; level++) {
+				int shift = SLOT_BITS * (level + 1);
+
+				if ((expires >> shift) == (this->current_tick >> shift)) {
+					slot = &this->wheel[level][(expires >> (SLOT_BITS * level)) & (SLOTS - 1)];
+					break;
+				}
+			}
+
+			push_link(slot, node, &ExpiringNode::timer_next, &ExpiringNode::timer_prev_link);
+		}
+
+		/// <summary>
+		/// Start tracking the timer of a node if it expires.
+		/// </summary>
+		void add_timer(ExpiringNode* node) {
+			if (node->expires == NEVER) return;
+
+			this->schedule(node, this->current_tick + 1);
+			this->timer_count++;
+		}
+
+		/// <summary>
+		/// Stop tracking the timer of a node.
+		/// </summary>
+		void remove_timer(ExpiringNode* node) {
+			if (node->timer_prev_link == nullptr) return;
+
+			pop_link(node, &ExpiringNode::timer_next, &ExpiringNode::timer_prev_link);
+			this->timer_count--;
+		}
+
+		/// <summary>
+		/// Move every timer in a list back into the wheel relative to the current tick.
+		/// </summary>
+		void cascade(ExpiringNode** slot) {
+			ExpiringNode* node = *slot;
+			*slot = nullptr;
+
+			while (node != nullptr) {
+				ExpiringNode* next = node->timer_next;
+
+				node->timer_next = nullptr;
+				node->timer_prev_link = nullptr;
+
+				//cascading runs before the current tick's slot is processed, so it may still be used
+				this->schedule(node, this->current_tick);
+
+				node = next;
+			}
+		}
+
+		/// <summary>
+		/// Find the next tick at which the wheel has work: a level 0 slot to expire, a higher level slot to cascade,
+		/// or the wrap of the top level while there are far timers. Slots before the current one are always empty,
+		/// so only the rest of each level's current block is searched, and a lower level's work always comes first.
+		/// </summary>
+		/// <returns>The tick, NEVER if no timer is set.</returns>
+		unsigned long long next_event() const {
+			for (int level = 0; level < LEVELS; level++) {
+				int shift = SLOT_BITS * level;
+				unsigned long long block = (this->current_tick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+
+				for (int slot = (int)((this->current_tick >> shift) & (SLOTS - 1)) + 1; slot < SLOTS; slot++) {
+					if (this->wheel[level][slot] != nullptr) return block + ((unsigned long long)slot << shift);
+				}
+			}
+
+			if (this->far_timers == nullptr) return NEVER;
+
+			int top = SLOT_BITS * LEVELS;
+			return ((this->current_tick >> top) + 1) << top;
+		}
+
+		/// <summary>
+		/// Unlink a node from its bucket and timer slot and free it.
+		/// </summary>
+		void destroy(ExpiringNode* node) {
+			this->remove_timer(node);
+			pop_link(node, &ExpiringNode::next, &ExpiringNode::prev_link);
+			this->count--;
+
+			delete node;
+		}
+
+	public:
+		/// <summary>
+		/// Create an ExpiringHashTable.
+		/// </summary>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		/// <param name="size">Number of buckets.</param>
+		/// <param name="tick">Granularity of expiration times.</param>
+		ExpiringHashTable(HASH_FUNC hashing_function, unsigned long size = 128, CLOCK::duration tick = std::chrono::milliseconds(1)) {
+			this->hash_function = hashing_function;
+			this->table_size = size;
+			this->resolution = tick;
+			this->epoch = CLOCK::now();
+
+			table = new ExpiringNode*[this->table_size]();
+		}
+
+		ExpiringHashTable(const ExpiringHashTable&) = delete;
+		ExpiringHashTable& operator= (const ExpiringHashTable&) = delete;
+
+		~ExpiringHashTable() {
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				ExpiringNode* node = this->table[i];
+
+				while (node != nullptr) {
+					ExpiringNode* next = node->next;
+					delete node;
+					node = next;
+				}
+			}
+
+			delete[] this->table;
+		}
+
+		/// <summary>
+		/// Insert or replace a value which never expires.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		void insert(const KT key, VT value) {
+			this->insert_until(key, value, NEVER);
+		}
+
+		/// <summary>
+		/// Insert or replace a value which expires after a given time to live.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		/// <param name="ttl">How long the entry stays in the table.</param>
+		/// <param name="now">The current time.</param>
+		void insert(const KT key, VT value, CLOCK::duration ttl, CLOCK::time_point now = CLOCK::now()) {
+			this->insert_until(key, value, this->to_tick(now + ttl));
+		}
+
+		/// <summary>
+		/// Get a pointer to a value by key, entries which have expired are removed and not returned.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <param name="now">The current time.</param>
+		/// <returns>Pointer to the value, nullptr if the key is missing or expired.</returns>
+		VT* get(KT key, CLOCK::time_point now = CLOCK::now()) {
+			ExpiringNode* node = this->find_node(key);
+
+			if (node == nullptr) return nullptr;
+
+			//lazily drop the entry if its time has passed
+			if (node->expires != NEVER && node->expires <= this->elapsed_tick(now)) {
+				this->destroy(node);
+				return nullptr;
+			}
+
+			return &node->value;
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the table.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			ExpiringNode* node = this->find_node(key);
+
+			if (node == nullptr) return false;
+
+			this->destroy(node);
+			return true;
+		}
+
+		/// <summary>
+		/// Remove every entry which has expired by the given time.
+		/// </summary>
+		/// <param name="now">The current time.</param>
+		/// <returns>The number of entries removed.</returns>
+		unsigned long expire(CLOCK::time_point now = CLOCK::now()) {
+			unsigned long long target = this->elapsed_tick(now);
+			unsigned long expired = 0;
+
+			while (this->current_tick < target) {
+				//skip the ticks without work, so the cost depends on the timers touched rather than the time elapsed
+				unsigned long long next = this->next_event();
+
+				if (next > target) {
+					this->current_tick = target;
+					break;
+				}
+
+				this->current_tick = next;
+
+				//when a level wraps, move the timers of the next level's current slot down
+				for (int level = 1; level <= LEVELS; level++) {
+					if ((this->current_tick & ((1ull << (SLOT_BITS * level)) - 1)) != 0) break;
+
+					if (level == LEVELS) this->cascade(&this->far_timers);
+					else this->cascade(&this->wheel[level][(this->current_tick >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+				}
+
+				//every timer left in the current level 0 slot is due
+				ExpiringNode** slot = &this->wheel[0][this->current_tick & (SLOTS - 1)];
+
+				while (*slot != nullptr) {
+					this->destroy(*slot);
+					expired++;
+				}
+			}
+
+			return expired;
+		}
+
+		/// <summary>
+		/// Return the number of Key/Value pairs stored in the table, including expired ones not yet removed.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->count;
+		}
+
+	private:
+		/// <summary>
+		/// Insert or replace a value with a given expiration tick.
+		/// </summary>
+		void insert_until(const KT& key, const VT& value, unsigned long long expires) {
+			ExpiringNode* node = this->find_node(key);
+
+			if (node != nullptr) {
+				//replace the value and restart the timer
+				this->remove_timer(node);
+				node->value = value;
+				node->expires = expires;
+			}
+			else {
+				node = new ExpiringNode(key, value, expires);
+				push_link(&this->table[this->hash_function(key, this->table_size)], node, &ExpiringNode::next, &ExpiringNode::prev_link);
+				this->count++;
+			}
+
+			this->add_timer(node);
+		}
+	};
+};
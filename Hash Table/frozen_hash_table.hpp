@@ -0,0 +1,270 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <climits>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// A read-only Hash Table built from a snapshot of a HashTable using a minimal perfect hash (CHD).
+	/// Every key is placed in its own slot, so a lookup reads one displacement and one slot.
+	/// Only keys which share their full hash with another key are kept in a small overflow list instead.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class FrozenHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+		/// <summary>
+		/// A key/value pair stored contiguously in the slot array.
+		/// </summary>
+		struct Slot {
+			KT key;
+			VT value;
+		};
+
+	private:
+		//average number of keys per displacement bucket
+		static constexpr unsigned long KEYS_PER_BUCKET = 4;
+
+		//one spare slot per this many keys, a completely full slot array leaves the last buckets almost no free slots to reach
+		static constexpr unsigned long KEYS_PER_SPARE_SLOT = 100;
+
+		//number of displacements tried for a bucket before the table is rebuilt with another seed
+		static constexpr unsigned int MAX_DISPLACEMENT = 1u << 16;
+
+		//number of seeds tried before buckets which can't be placed are moved to the overflow list
+		static constexpr unsigned int MAX_SEEDS = 4;
+
+		//displacement value marking a bucket whose keys live in the overflow list
+		static constexpr unsigned int OVERFLOW_DISPLACEMENT = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		//number of key/value pairs stored
+		unsigned long item_count = 0;
+
+		//selects the bucket and slot hashes, a multiple of MAX_DISPLACEMENT + 1 so seeds never share a displacement hash
+		unsigned long long seed = 0;
+
+		//one displacement per bucket, used to pick the slot of every key in the bucket
+		std::vector<unsigned int> displacements;
+
+		//packed key/value pairs, one per key plus a few spare slots
+		std::vector<Slot> slots;
+
+		//keys of buckets holding two keys with the same full hash, which no displacement can separate
+		std::vector<Slot> overflow;
+
+		/// <summary>
+		/// Get the full width hash of a key.
+		/// </summary>
+		unsigned long long full_hash(const KT& key) const {
+			return this->hash_function(key, ULONG_MAX);
+		}
+
+		/// <summary>
+		/// Get the displacement bucket of a full hash.
+		/// </summary>
+		unsigned long long bucket_of(unsigned long long hash) const {
+			return mix_hash(hash, this->seed) % this->displacements.size();
+		}
+
+		/// <summary>
+		/// Get the slot of a full hash for a given displacement.
+		/// </summary>
+		unsigned long long slot_of(unsigned long long hash, unsigned int displacement) const {
+			return mix_hash(hash, this->seed + displacement) % this->slots.size();
+		}
+
+		/// <summary>
+		/// Try to place every key with the current seed.
+		/// </summary>
+		/// <param name="keep_overflow">Move buckets without a working displacement to the overflow list instead of failing.</param>
+		/// <returns>If only buckets with a shared full hash went to the overflow list.</returns>
+		bool build(const std::vector<std::pair<KT, VT>>& items, const std::vector<unsigned long long>& hashes, bool keep_overflow) {
+			size_t count = items.size();
+
+			//empty buckets keep displacement 1 so a lookup in them never scans the overflow list
+			this->displacements.assign((count + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET, 1);
+			this->overflow.clear();
+
+			//group the keys by bucket
+			std::vector<std::vector<size_t>> buckets(this->displacements.size());
+
+			for (size_t i = 0; i < count; i++) {
+				buckets[this->bucket_of(hashes[i])].push_back(i);
+			}
+
+			//place the largest buckets first while the most slots are still free
+			std::vector<size_t> order(buckets.size());
+			for (size_t i = 0; i < order.size(); i++) {
+				order[i] = i;
+			}
+
+			std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+				return buckets[a].size() > buckets[b].size();
+			});
+
+			std::vector<bool> taken(this->slots.size(), false);
+			std::vector<unsigned long long> candidate;
+
+			for (auto b : order) {
+				auto& bucket = buckets[b];
+
+				//buckets are sorted by size so every remaining bucket is empty
+				if (bucket.empty()) break;
+
+				//keys with the same full hash always land in the same slot, only the overflow list can hold them
+				bool shared_hash = false;
+				for (size_t j = 0; j < bucket.size() && !shared_hash; j++) {
+					for (size_t k = j + 1; k < bucket.size(); k++) {
+						if (hashes[bucket[j]] == hashes[bucket[k]]) {
+							shared_hash = true;
+							break;
+						}
+					}
+				}
+
+				bool placed = false;
+
+				//search for a displacement that maps every key of the bucket to a distinct free slot
+				for (unsigned int d = 1; d <= MAX_DISPLACEMENT && !shared_hash; d++) {
+					candidate.clear();
+
+					bool fits = true;
+					for (auto i : bucket) {
+						auto slot = this->slot_of(hashes[i], d);
+
+						if (taken[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+							fits = false;
+							break;
+						}
+
+						candidate.push_back(slot);
+					}
+
+					if (fits) {
+						for (size_t j = 0; j < bucket.size(); j++) {
+							taken[candidate[j]] = true;
+							this->slots[candidate[j]] = Slot{ items[bucket[j]].first, items[bucket[j]].second };
+						}
+
+						this->displacements[b] = d;
+						placed = true;
+						break;
+					}
+				}
+
+				if (placed) continue;
+
+				//an unlucky seed, try another one before giving up on a fixed number of reads
+				if (!shared_hash && !keep_overflow) return false;
+
+				this->displacements[b] = OVERFLOW_DISPLACEMENT;
+
+				for (auto i : bucket) {
+					this->overflow.push_back(Slot{ items[i].first, items[i].second });
+				}
+			}
+
+			//fill the spare slots with a real pair so that a stray lookup can never match a default key
+			Slot filler = this->overflow.empty() ? Slot() : this->overflow.front();
+			for (size_t i = 0; i < this->slots.size(); i++) {
+				if (taken[i]) {
+					filler = this->slots[i];
+					break;
+				}
+			}
+
+			for (size_t i = 0; i < this->slots.size(); i++) {
+				if (!taken[i]) this->slots[i] = filler;
+			}
+
+			return true;
+		}
+
+	public:
+		/// <summary>
+		/// Build a FrozenHashTable from a list of unique key/value pairs.
+		/// </summary>
+		/// <param name="items">Unique key/value pairs to be stored.</param>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		FrozenHashTable(const std::vector<std::pair<KT, VT>>& items, HASH_FUNC hashing_function) {
+			this->hash_function = hashing_function;
+
+			size_t count = items.size();
+			this->item_count = (unsigned long)count;
+			if (count == 0) return;
+
+			this->slots.resize(count + count / KEYS_PER_SPARE_SLOT + 1);
+
+			//hash every key once
+			std::vector<unsigned long long> hashes(count);
+
+			for (size_t i = 0; i < count; i++) {
+				hashes[i] = this->full_hash(items[i].first);
+			}
+
+			for (unsigned int attempt = 1; !this->build(items, hashes, attempt == MAX_SEEDS); attempt++) {
+				this->seed += (unsigned long long)MAX_DISPLACEMENT + 1;
+			}
+		}
+
+		/// <summary>
+		/// Return the number of keys kept in the overflow list, which is 0 unless two keys share a full hash.
+		/// </summary>
+		size_t overflow_size() const {
+			return this->overflow.size();
+		}
+
+		/// <summary>
+		/// Get a pointer to the value stored by a given key.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>Pointer to the value, nullptr if the key is not in the table.</returns>
+		const VT* get(KT key) const {
+			if (this->slots.empty()) return nullptr;
+
+			auto hash = this->full_hash(key);
+			auto displacement = this->displacements[this->bucket_of(hash)];
+
+			//a key of a placed bucket can only be in its slot
+			if (displacement != OVERFLOW_DISPLACEMENT) {
+				const Slot& slot = this->slots[this->slot_of(hash, displacement)];
+
+				return slot.key == key ? &slot.value : nullptr;
+			}
+
+			//only reached for buckets holding keys with a colliding full hash
+			for (auto& slot : this->overflow) {
+				if (slot.key == key) {
+					return &slot.value;
+				}
+			}
+
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Check if the table contains a given key.
+		/// </summary>
+		bool contains(KT key) const {
+			return this->get(key) != nullptr;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->item_count;
+		}
+	};
+};
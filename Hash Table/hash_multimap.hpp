@@ -0,0 +1,310 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// A vector which stores its first N items inside the object and only allocates once it grows past them.
+	/// </summary>
+	/// <typeparam name="T">The type of the stored items.</typeparam>
+	/// <typeparam name="N">The number of items stored inline.</typeparam>
+	template <typename T, unsigned int N>
+	class SmallVector
+	{
+	private:
+		//inline storage used until the vector grows past N items
+		T inline_items[N];
+
+		//heap storage used once the vector grows past N items
+		std::vector<T> heap_items;
+
+		//number of items stored
+		size_t count = 0;
+
+	public:
+		/// <summary>
+		/// Pointer to the first item.
+		/// </summary>
+		T* begin() {
+			return this->heap_items.empty() ? this->inline_items : this->heap_items.data();
+		}
+
+		/// <summary>
+		/// Pointer past the last item.
+		/// </summary>
+		T* end() {
+			return this->begin() + this->count;
+		}
+
+		/// <summary>
+		/// Return the number of items stored.
+		/// </summary>
+		size_t size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Check if the vector has moved its items to the heap.
+		/// </summary>
+		bool on_heap() const {
+			return !this->heap_items.empty();
+		}
+
+		/// <summary>
+		/// Add an item to the end of the vector.
+		/// </summary>
+		void push_back(const T& item) {
+			if (this->heap_items.empty() && this->count < N) {
+				this->inline_items[this->count++] = item;
+				return;
+			}
+
+			//move the inline items to the heap the first time the vector outgrows them
+			if (this->heap_items.empty()) {
+				this->heap_items.reserve(N * 2);
+
+				for (size_t i = 0; i < this->count; i++) {
+					this->heap_items.push_back(std::move(this->inline_items[i]));
+				}
+			}
+
+			this->heap_items.push_back(item);
+			this->count++;
+		}
+
+		/// <summary>
+		/// Remove the item at an index, keeping the order of the remaining items.
+		/// </summary>
+		void erase(size_t index) {
+			if (!this->heap_items.empty()) {
+				this->heap_items.erase(this->heap_items.begin() + index);
+			}
+			else {
+				for (size_t i = index; i + 1 < this->count; i++) {
+					this->inline_items[i] = std::move(this->inline_items[i + 1]);
+				}
+
+				this->inline_items[this->count - 1] = T();
+			}
+
+			this->count--;
+		}
+	};
+
+	/// <summary>
+	/// A Hash Table which maps each key to a group of values.
+	/// Every distinct key is stored once, with its values held together in a SmallVector.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry values.</typeparam>
+	template <typename KT, typename VT>
+	class HashMultiMap
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+		/// <summary>
+		/// Number of values stored inside a key node before they are moved to the heap.
+		/// </summary>
+		static constexpr unsigned int INLINE_VALUES = 2;
+
+		/// <summary>
+		/// Object representing a key and all of its values.
+		/// </summary>
+		struct KeyNode {
+			/// <summary>
+			/// Reference to the next node in the same bucket.
+			/// </summary>
+			KeyNode* next = nullptr;
+
+			/// <summary>
+			/// Key of the node.
+			/// </summary>
+			KT key;
+
+			/// <summary>
+			/// Values stored for the key, in insertion order.
+			/// </summary>
+			SmallVector<VT, INLINE_VALUES> values;
+
+			KeyNode(KT key) {
+				this->key = key;
+			}
+		};
+
+	private:
+		//bucket chains
+		KeyNode** table;
+
+		//table values
+		unsigned long table_size;
+		unsigned long key_total = 0;
+		unsigned long value_total = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		/// <summary>
+		/// Find the link pointing at the node with the specified key.
+		/// </summary>
+		/// <returns>Pointer to the link, the link holds nullptr if no matching node was found.</returns>
+		KeyNode** find_link(const KT& key) {
+			KeyNode** link = &this->table[this->hash_function(key, this->table_size)];
+
+			while (*link != nullptr && !((*link)->key == key)) {
+				link = &(*link)->next;
+			}
+
+			return link;
+		}
+
+		/// <summary>
+		/// Unlink a node from its bucket and free it.
+		/// </summary>
+		void destroy(KeyNode** link) {
+			KeyNode* node = *link;
+			*link = node->next;
+
+			this->key_total--;
+			this->value_total -= (unsigned long)node->values.size();
+
+			delete node;
+		}
+
+	public:
+		//constructor
+		HashMultiMap(HASH_FUNC hashing_function, unsigned long size = 128) {
+			this->hash_function = hashing_function;
+			this->table_size = size;
+
+			table = new KeyNode*[this->table_size]();
+		}
+
+		HashMultiMap(const HashMultiMap&) = delete;
+		HashMultiMap& operator= (const HashMultiMap&) = delete;
+
+		~HashMultiMap() {
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				while (this->table[i] != nullptr) {
+					this->destroy(&this->table[i]);
+				}
+			}
+
+			delete[] this->table;
+		}
+
+		/// <summary>
+		/// Add a value to the group of values stored for a key.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value to be added.</param>
+		void insert(const KT key, VT value) {
+			KeyNode** link = this->find_link(key);
+
+			//create the key node the first time the key is seen
+			if (*link == nullptr) {
+				*link = new KeyNode(key);
+				this->key_total++;
+			}
+
+			(*link)->values.push_back(value);
+			this->value_total++;
+		}
+
+		/// <summary>
+		/// Get a pointer to the first value stored for a key.
+		/// </summary>
+		/// <param name="key">The key representing the values.</param>
+		/// <returns>Pointer to the first value, nullptr if the key is not in the table.</returns>
+		VT* get(KT key) {
+			KeyNode* node = *this->find_link(key);
+
+			return node == nullptr ? nullptr : node->values.begin();
+		}
+
+		/// <summary>
+		/// Get the range of values stored for a key.
+		/// </summary>
+		/// <param name="key">The key representing the values.</param>
+		/// <returns>Pointers to the first value and past the last value, both nullptr if the key is not in the table.</returns>
+		std::pair<VT*, VT*> equal_range(KT key) {
+			KeyNode* node = *this->find_link(key);
+
+			if (node == nullptr) return std::pair<VT*, VT*>(nullptr, nullptr);
+
+			return std::pair<VT*, VT*>(node->values.begin(), node->values.end());
+		}
+
+		/// <summary>
+		/// Return the number of values stored for a key.
+		/// </summary>
+		unsigned long count(KT key) {
+			KeyNode* node = *this->find_link(key);
+
+			return node == nullptr ? 0 : (unsigned long)node->values.size();
+		}
+
+		/// <summary>
+		/// Remove a key and all of its values.
+		/// </summary>
+		/// <param name="key">The key to be removed.</param>
+		/// <returns>The number of values removed.</returns>
+		unsigned long erase(KT key) {
+			KeyNode** link = this->find_link(key);
+
+			if (*link == nullptr) return 0;
+
+			unsigned long removed = (unsigned long)(*link)->values.size();
+			this->destroy(link);
+
+			return removed;
+		}
+
+		/// <summary>
+		/// Remove the first matching value stored for a key, the key is removed with its last value.
+		/// </summary>
+		/// <param name="key">The key of the value.</param>
+		/// <param name="value">The value to be removed.</param>
+		/// <returns>If a matching value was found and removed.</returns>
+		bool erase_one(KT key, const VT& value) {
+			KeyNode** link = this->find_link(key);
+
+			if (*link == nullptr) return false;
+
+			auto& values = (*link)->values;
+
+			for (size_t i = 0; i < values.size(); i++) {
+				if (values.begin()[i] == value) {
+					if (values.size() == 1) {
+						this->destroy(link);
+					}
+					else {
+						values.erase(i);
+						this->value_total--;
+					}
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Return the total number of values stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->value_total;
+		}
+
+		/// <summary>
+		/// Return the number of distinct keys stored in the table.
+		/// </summary>
+		unsigned long key_count() const {
+			return this->key_total;
+		}
+	};
+};
@@ -2,6 +2,25 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <thread>
+#include <climits>
+#include <optional>
+#include "bloom_filter.hpp"
+#include "work_stealing_pool.hpp"
+
+//lets an empty allocator member take no space, MSVC ignores the standard attribute and only honours its own spelling
+#if defined(_MSC_VER)
+#define HASH_TABLE_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define HASH_TABLE_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
 
 namespace hash_table {
 	//function used to help space out the table properly
@@ -15,17 +34,107 @@ namespace hash_table {
 		return str;
 	}
 
+	//function used to spread a hash value over all bits (splitmix64 finalizer), seed selects an independent hash
+	inline unsigned long long mix_hash(unsigned long long hash, unsigned long long seed = 0) {
+		hash ^= seed * 0x9E3779B97F4A7C15ull;
+		hash ^= hash >> 30;
+		hash *= 0xBF58476D1CE4E5B9ull;
+		hash ^= hash >> 27;
+		hash *= 0x94D049BB133111EBull;
+		hash ^= hash >> 31;
+
+		return hash;
+	}
+
+	/// <summary>
+	/// Return the heap bytes owned by a key or value outside of its own object, overload this for types which own memory.
+	/// </summary>
+	template <typename T>
+	size_t out_of_line_bytes(const T&) {
+		return 0;
+	}
+
+	/// <summary>
+	/// Return the heap bytes of a string, strings short enough to be stored inside the object (SSO) own none.
+	/// </summary>
+	template <typename CharT, typename Traits, typename StringAllocator>
+	size_t out_of_line_bytes(const std::basic_string<CharT, Traits, StringAllocator>& text) {
+		const char* data = (const char*)text.data();
+		const char* object = (const char*)&text;
+
+		if (data >= object && data < object + sizeof(text)) return 0;
+
+		return (text.capacity() + 1) * sizeof(CharT);
+	}
+
+	/// <summary>
+	/// Breakdown of the bytes used by a table.
+	/// </summary>
+	struct MemoryUsage {
+		/// <summary>
+		/// Bytes of the bucket array.
+		/// </summary>
+		size_t bucket_array = 0;
+
+		/// <summary>
+		/// Bytes of the HashEntry objects of non-empty buckets.
+		/// </summary>
+		size_t entries = 0;
+
+		/// <summary>
+		/// Bytes of the HashNode objects, including the keys and values stored inside them.
+		/// </summary>
+		size_t nodes = 0;
+
+		/// <summary>
+		/// Heap bytes owned by keys and values outside of their nodes, such as long strings.
+		/// </summary>
+		size_t out_of_line = 0;
+
+		/// <summary>
+		/// Bytes of the Bloom filter, 0 when it is disabled.
+		/// </summary>
+		size_t bloom_filter = 0;
+
+		/// <summary>
+		/// Return the total number of bytes.
+		/// </summary>
+		size_t total() const {
+			return this->bucket_array + this->entries + this->nodes + this->out_of_line + this->bloom_filter;
+		}
+	};
+
+	template <typename KT, typename VT>
+	class FrozenHashTable;
+
+	template <typename KT, typename VT>
+	class CowHashTable;
+
+	template <typename KT, typename VT>
+	class DurableHashTable;
+
+	template <typename KT, typename VT, typename Allocator = std::allocator<std::pair<const KT, VT>>>
+	class LookupPipeline;
+
 
 	/// <summary>
 	/// A templated Hash Table implimentation.
 	/// </summary>
 	/// <typeparam name="KT">The type of the entry key.</typeparam>
 	/// <typeparam name="VT">The type of the entry value.</typeparam>
-	/// <typeparam name="FUNCTION">The type of the hashing function.</typeparam>
-	template <typename KT, typename VT>
+	/// <typeparam name="Allocator">Allocator used for the bucket array, entries and nodes. Keys and values which allocate on their own,
+	/// such as strings, keep using their own allocator.</typeparam>
+	template <typename KT, typename VT, typename Allocator = std::allocator<std::pair<const KT, VT>>>
 	class HashTable
 	{
+		friend LookupPipeline<KT, VT, Allocator>;
+		friend DurableHashTable<KT, VT>;
+
 	public:
+		/// <summary>
+		/// Hashes a key to a bucket index in [0, size). The Bloom filter and freeze() also call it with a size of ULONG_MAX
+		/// to get a full width hash of the key, so it should keep the high bits of its hash for large sizes.
+		/// </summary>
 		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
 
 		/// <summary>
@@ -36,6 +145,7 @@ namespace hash_table {
 		class HashEntry
 		{
 			friend HashTable;
+			friend CowHashTable<KT, VT>;
 
 		public:
 			struct HashNode {
@@ -66,36 +176,32 @@ namespace hash_table {
 					this->key = key;
 					this->value = value;
 				}
+			};
 
-				~HashNode() {
-					//delete the next node in the list if it exists
-					if (this->back != nullptr) {
-						delete this->back;
-						this->back = nullptr;
-					}
-				}
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<HashNode> NODE_ALLOCATOR;
+			typedef std::allocator_traits<NODE_ALLOCATOR> NODE_TRAITS;
 
-			private:
-				/// <summary>
-				/// Copy this node, including its links to subsequent nodes.
-				/// </summary>
-				/// <returns>Copy of the current node.</returns>
-				HashNode* copy() {
-					HashNode* node = new HashNode(this->key, this->value);
-					node->front = this->front == nullptr ? nullptr : this->front->copy();
-					return node;
-				}
+		private:
+			//allocator the nodes of this entry come from
+			HASH_TABLE_NO_UNIQUE_ADDRESS NODE_ALLOCATOR node_allocator;
 
-				/// <summary>
-				/// Returns the node in the link.
-				/// </summary>
-				/// <returns>Returns the last node in the link.</returns>
-				HashNode* last() {
-					return this->front == nullptr ? this : this->front->last();
-				}
-			};
+			/// <summary>
+			/// Allocate and construct a node.
+			/// </summary>
+			HashNode* create_node(const KT& key, const VT& value) {
+				HashNode* node = NODE_TRAITS::allocate(this->node_allocator, 1);
+				NODE_TRAITS::construct(this->node_allocator, node, key, value);
+				return node;
+			}
+
+			/// <summary>
+			/// Destroy and free a node, the nodes linked to it are left alone.
+			/// </summary>
+			void destroy_node(HashNode* node) {
+				NODE_TRAITS::destroy(this->node_allocator, node);
+				NODE_TRAITS::deallocate(this->node_allocator, node, 1);
+			}
 
-		private:
 			/// <summary>
 			/// Find a HashNode with the specified key.
 			/// </summary>
@@ -119,13 +225,74 @@ namespace hash_table {
 				return nullptr;
 			}
 
+			/// <summary>
+			/// Append a copy of every node of another entry, in order, using this entry's allocator.
+			/// </summary>
+			/// <param name="other">The entry to copy.</param>
+			void copy_nodes(const HashEntry& other) {
+				for (HashNode* current = other.head; current != nullptr; current = current->back) {
+					HashNode* node = this->create_node(current->key, current->value);
+
+					node->front = this->tail;
+
+					if (this->tail == nullptr) this->head = node;
+					else this->tail->back = node;
+
+					this->tail = node;
+				}
+			}
+
+			/// <summary>
+			/// Link an existing node in at the front of the list.
+			/// </summary>
+			void push_node(HashNode* node) {
+				node->front = nullptr;
+				node->back = this->head;
+
+				if (this->head == nullptr) this->tail = node;
+				else this->head->front = node;
+
+				this->head = node;
+			}
+
+			/// <summary>
+			/// Remove and delete every node whose key and value match a predicate.
+			/// </summary>
+			/// <returns>The number of nodes removed.</returns>
+			template <typename PREDICATE>
+			unsigned long erase_if(PREDICATE& predicate) {
+				unsigned long removed = 0;
+				HashNode* current_node = this->head;
+
+				while (current_node != nullptr) {
+					HashNode* next_node = current_node->back;
+
+					//the pair is passed as const, a predicate changing the key would leave it in the wrong bucket
+					if (predicate(std::as_const(current_node->key), std::as_const(current_node->value))) {
+						//unlink the node
+						if (current_node->front == nullptr) this->head = next_node;
+						else current_node->front->back = next_node;
+
+						if (next_node == nullptr) this->tail = current_node->front;
+						else next_node->front = current_node->front;
+
+						this->destroy_node(current_node);
+						removed++;
+					}
+
+					current_node = next_node;
+				}
+
+				return removed;
+			}
+
 			/// <summary>
 			/// Return a copy of this object.
 			/// </summary>
 			/// <returns>Return a copy of this object.</returns>
 			HashEntry* copy() {
-				HashEntry* entry = new HashEntry();
-				entry->head = this->head = nullptr ? nullptr : this->head->copy();
+				HashEntry* entry = new HashEntry(this->node_allocator);
+				entry->copy_nodes(*this);
 				return entry;
 			}
 
@@ -140,11 +307,18 @@ namespace hash_table {
 			/// </summary>
 			HashNode* tail = nullptr;
 
-			HashEntry() {}
+			HashEntry(const NODE_ALLOCATOR& node_allocator = NODE_ALLOCATOR()) : node_allocator(node_allocator) {}
 
 			~HashEntry() {
-				//delete all nodes to free memory
-				delete this->head;
+				//delete all nodes to free memory, one at a time so long chains can't overflow the stack
+				HashNode* current_node = this->head;
+
+				while (current_node != nullptr) {
+					HashNode* next_node = current_node->back;
+					this->destroy_node(current_node);
+					current_node = next_node;
+				}
+
 				this->head = nullptr;
 				this->tail = nullptr;
 			}
@@ -155,7 +329,7 @@ namespace hash_table {
 			/// <param name="key"></param>
 			/// <param name="value"></param>
 			void push(KT key, VT value) {
-				HashNode* new_node = new HashNode(key, value);
+				HashNode* new_node = this->create_node(key, value);
 
 				//case if there are no existing nodes
 				if (this->head == nullptr) {
@@ -205,62 +379,32 @@ namespace hash_table {
 				HashNode* node_front = node->front;
 				HashNode* node_back = node->back;
 
-				//if the node we found is the only node in the list then set both the front and end node to null and delete the node
+				//if the node we found is the only node in the list then set both the front and end node to null
 				if (node == this->head && node == this->tail) {
 					this->head = nullptr;
 					this->tail = nullptr;
-
-					//set the front and back to nullptr to prevent cascading node deletion
-					node->front = nullptr;
-					node->back = nullptr;
-
-					//delete the node
-					delete node;
-					return true;
 				}
 				//if the node to be deleted is the begining node of the LinkedList
 				else if (node == this->head) {
 					//set the node behind the node to be deleted to the new begining node and set that node's new front node to null
 					this->head = node->back;
 					this->head->front = nullptr;
-
-					//set the front and back to nullptr to prevent cascading node deletion
-					node->front = nullptr;
-					node->back = nullptr;
-
-					//delete the node
-					delete node;
-					return true;
 				}
 				//if the node to be deleted is the end node of the LinkedList
 				else if (node == this->tail) {
 					//set the node in front the node to be deleted to the new bend node and set that node's new end node to null
 					this->tail = node->front;
 					this->tail->back = nullptr;
-
-					//set the front and back to nullptr to prevent cascading node deletion
-					node->front = nullptr;
-					node->back = nullptr;
-
-					//delete the node
-					delete node;
-					return true;
 				}
-				//no special conditons just remove the node
+				//no special conditons just unlink the node
 				else {
 					node_front->back = node_back;
 					node_back->front = node_front;
-
-					//set the front and back to nullptr to prevent cascading node deletion
-					node->front = nullptr;
-					node->back = nullptr;
-
-					//delete the node
-					delete node;
-					return true;
 				}
 
-				return false;
+				//delete the node
+				this->destroy_node(node);
+				return true;
 			}
 
 			/// <summary>
@@ -302,6 +446,14 @@ namespace hash_table {
 		};
 
 	private:
+		typedef std::allocator_traits<Allocator> ALLOCATOR_TRAITS;
+		typedef typename ALLOCATOR_TRAITS::template rebind_alloc<HashEntry> ENTRY_ALLOCATOR;
+		typedef typename ALLOCATOR_TRAITS::template rebind_alloc<HashEntry*> BUCKET_ALLOCATOR;
+		typedef typename HashEntry::HashNode HashNode;
+
+		//allocator the bucket array, entries and nodes come from
+		HASH_TABLE_NO_UNIQUE_ADDRESS Allocator allocator;
+
 		//pointer to the front of the hash table
 		HashEntry** table;
 
@@ -311,38 +463,224 @@ namespace hash_table {
 		//function used to hash keys
 		HASH_FUNC hash_function;
 
+		//minimum number of buckets each thread copies in clone()
+		static constexpr unsigned long MIN_CLONE_BUCKETS = 4096;
+
+		//number of buckets in each chunk of a parallel scan
+		static constexpr unsigned long SCAN_CHUNK_BUCKETS = 1024;
+
+		//longest run of a chain visited as part of a bucket chunk, the rest of a longer chain is split into segments of this many nodes
+		static constexpr unsigned long SCAN_CHUNK_NODES = 1024;
+
+		//segments a parallel scan can record per worker, chains past that many segments are visited by the worker which finds them
+		static constexpr unsigned long SCAN_SEGMENTS_PER_WORKER = 256;
+
+		//optional filter checked before any bucket is read, nullptr when disabled
+		BloomFilter* bloom = nullptr;
+
+		//filter bits per key and the number of removed keys whose bits are still set
+		double bloom_bits_per_key = 10;
+		unsigned long bloom_stale = 0;
+
+		//keys added to or removed from the filter since it was built
+		unsigned long bloom_updates = 0;
+
+		//a rebuild reads every bucket, so it waits for at least one update per this many buckets
+		static constexpr unsigned long BLOOM_REBUILD_BUCKETS = 8;
+
+		/// <summary>
+		/// Get the full width hash of a key, used by the Bloom filter and freeze(). Buckets are still chosen by
+		/// hash_function(key, table_size), so tables without a filter never compute it.
+		/// </summary>
+		unsigned long full_hash(const KT& key) const {
+			return this->hash_function(key, ULONG_MAX);
+		}
+
+		/// <summary>
+		/// Get the hash used by the Bloom filter from a key's full hash.
+		/// </summary>
+		static unsigned long long bloom_hash(unsigned long hash) {
+			return mix_hash(hash, 0xB100F11E);
+		}
+
+		/// <summary>
+		/// Check if enough updates were made since the filter was built to pay for reading every bucket again.
+		/// </summary>
+		bool bloom_rebuild_allowed() const {
+			return this->bloom_updates * BLOOM_REBUILD_BUCKETS >= this->table_size;
+		}
+
+		/// <summary>
+		/// Replace the Bloom filter with a new one holding every key currently in the table.
+		/// </summary>
+		void rebuild_bloom(unsigned long expected_keys) {
+			//the old filter already knows how many keys are left, only count them when there is none
+			unsigned long count = this->bloom == nullptr ? this->size() : (unsigned long)this->bloom->size() - this->bloom_stale;
+
+			delete this->bloom;
+			this->bloom = new BloomFilter(expected_keys > count ? expected_keys : count, this->bloom_bits_per_key);
+			this->bloom_stale = 0;
+			this->bloom_updates = 0;
+
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				if (this->table[i] == nullptr) continue;
+
+				for (auto node = this->table[i]->head; node != nullptr; node = node->back) {
+					this->bloom->add(bloom_hash(this->full_hash(node->key)));
+				}
+			}
+		}
+
+		/// <summary>
+		/// Allocate a bucket array with every bucket empty.
+		/// </summary>
+		HashEntry** allocate_table(unsigned long size) {
+			BUCKET_ALLOCATOR bucket_allocator(this->allocator);
+
+			HashEntry** buckets = std::allocator_traits<BUCKET_ALLOCATOR>::allocate(bucket_allocator, size);
+			std::uninitialized_fill_n(buckets, size, nullptr);
+
+			return buckets;
+		}
+
+		/// <summary>
+		/// Allocate and construct an empty entry whose nodes come from this table's allocator.
+		/// </summary>
+		HashEntry* create_entry() {
+			ENTRY_ALLOCATOR entry_allocator(this->allocator);
+
+			HashEntry* entry = std::allocator_traits<ENTRY_ALLOCATOR>::allocate(entry_allocator, 1);
+			std::allocator_traits<ENTRY_ALLOCATOR>::construct(entry_allocator, entry, typename HashEntry::NODE_ALLOCATOR(this->allocator));
+
+			return entry;
+		}
+
+		/// <summary>
+		/// Destroy and free an entry along with its nodes.
+		/// </summary>
+		void destroy_entry(HashEntry* entry) {
+			ENTRY_ALLOCATOR entry_allocator(this->allocator);
+
+			std::allocator_traits<ENTRY_ALLOCATOR>::destroy(entry_allocator, entry);
+			std::allocator_traits<ENTRY_ALLOCATOR>::deallocate(entry_allocator, entry, 1);
+		}
+
+		/// <summary>
+		/// Copy an entry using this table's allocator.
+		/// </summary>
+		HashEntry* copy_entry(const HashEntry* entry) {
+			if (entry == nullptr) return nullptr;
+
+			HashEntry* copy = this->create_entry();
+			copy->copy_nodes(*entry);
+
+			return copy;
+		}
+
 		/// <summary>
 		/// Dallocate all memory in this class.
 		/// </summary>
 		void deallocate() {
-			//delete all HashEntries
-			for (int i = 0; i < this->table_size; ++i) {
-				delete this->table[i];
-				this->table[i] = nullptr;
+			//a moved from table has nothing to free
+			if (this->table != nullptr) {
+				//delete all HashEntries
+				for (unsigned long i = 0; i < this->table_size; ++i) {
+					if (this->table[i] != nullptr) this->destroy_entry(this->table[i]);
+					this->table[i] = nullptr;
+				}
+
+				//delete the table
+				BUCKET_ALLOCATOR bucket_allocator(this->allocator);
+				std::allocator_traits<BUCKET_ALLOCATOR>::deallocate(bucket_allocator, this->table, this->table_size);
+				this->table = nullptr;
 			}
 
-			//delete the table
-			delete[] this->table;
+			//delete the filter
+			delete this->bloom;
+			this->bloom = nullptr;
 		}
 
 		/// <summary>
-		/// Return the table, removes responsability for this HashTable managing it's memory.
+		/// Copy the buckets and filter of another table into this empty table using this table's allocator.
 		/// </summary>
-		/// <returns></returns>
-		HashEntry** copy() const {
-			HashEntry** tableCopy = new HashEntry * [this->table_size]();
-			
+		void copy(const HashTable& other) {
+			this->hash_function = other.hash_function;
+			this->table_size = other.table_size;
+			this->table = this->allocate_table(this->table_size);
+
 			//copy all entries
-			for (int i = 0; i < this->table_size; ++i) {
-				tableCopy[i] = table[i] == nullptr ? nullptr : table[i]->copy();
+			for (unsigned long i = 0; i < this->table_size; ++i) {
+				this->table[i] = this->copy_entry(other.table[i]);
 			}
 
-			return tableCopy;
+			this->bloom = other.bloom == nullptr ? nullptr : new BloomFilter(*other.bloom);
+			this->bloom_bits_per_key = other.bloom_bits_per_key;
+			this->bloom_stale = other.bloom_stale;
+			this->bloom_updates = other.bloom_updates;
+		}
+
+		/// <summary>
+		/// Call visit(node, worker) for every node on a work stealing pool.
+		/// The buckets are first scanned in chunks, visiting at most SCAN_CHUNK_NODES nodes of each chain. The rest of a longer chain
+		/// is cut into segments of SCAN_CHUNK_NODES nodes which are run as chunks of a second pass, so one long chain is shared by the workers.
+		/// The segment list is allocated before the first pass, once it is full the remaining long chains are visited where they are found.
+		/// </summary>
+		template <typename VISIT>
+		void parallel_scan(VISIT& visit, WorkStealingPool& pool) {
+			//first node of every segment, claimed through a shared counter
+			unsigned long capacity = pool.worker_count() * SCAN_SEGMENTS_PER_WORKER;
+			std::unique_ptr<HashNode*[]> starts(new HashNode*[capacity]);
+			std::atomic<unsigned long> claimed{ 0 };
+
+			auto scan_chunk = [this, &visit, &starts, &claimed, capacity](unsigned long chunk, unsigned int worker) {
+				unsigned long begin = chunk * SCAN_CHUNK_BUCKETS;
+				unsigned long end = begin + SCAN_CHUNK_BUCKETS < this->table_size ? begin + SCAN_CHUNK_BUCKETS : this->table_size;
+
+				for (unsigned long i = begin; i < end; i++) {
+					if (this->table[i] == nullptr) continue;
+
+					HashNode* node = this->table[i]->head;
+
+					for (unsigned long visited = 0; node != nullptr && visited < SCAN_CHUNK_NODES; visited++, node = node->back) {
+						visit(node, worker);
+					}
+
+					//only walk the rest of a long chain here, its recorded segments are visited in the second pass
+					for (unsigned long skipped = 0; node != nullptr; skipped++, node = node->back) {
+						if (skipped % SCAN_CHUNK_NODES != 0) continue;
+
+						unsigned long segment = claimed.fetch_add(1, std::memory_order_relaxed);
+						if (segment >= capacity) break;
+
+						starts[segment] = node;
+					}
+
+					//the segment list is full, visit the rest of the chain from the first segment which was not recorded
+					for (; node != nullptr; node = node->back) {
+						visit(node, worker);
+					}
+				}
+			};
+
+			pool.run((this->table_size + SCAN_CHUNK_BUCKETS - 1) / SCAN_CHUNK_BUCKETS, scan_chunk);
+
+			unsigned long segments = claimed.load(std::memory_order_relaxed);
+			if (segments > capacity) segments = capacity;
+
+			auto scan_segment = [&visit, &starts](unsigned long segment, unsigned int worker) {
+				HashNode* node = starts[segment];
+
+				for (unsigned long visited = 0; node != nullptr && visited < SCAN_CHUNK_NODES; visited++, node = node->back) {
+					visit(node, worker);
+				}
+			};
+
+			pool.run(segments, scan_segment);
 		}
 
 	public:
 		//constructor
-		HashTable(HASH_FUNC hashing_function, unsigned long size = 128) {
+		HashTable(HASH_FUNC hashing_function, unsigned long size = 128, const Allocator& allocator = Allocator()) : allocator(allocator) {
 			//set the hash function
 			this->hash_function = hashing_function;
 
@@ -350,7 +688,32 @@ namespace hash_table {
 			this->table_size = size;
 
 			//create a table
-			table = new HashEntry*[this->table_size]();
+			table = this->allocate_table(this->table_size);
+		}
+
+		//copy constructor
+		HashTable(const HashTable& other) : allocator(ALLOCATOR_TRAITS::select_on_container_copy_construction(other.allocator)) {
+			this->copy(other);
+		}
+
+		//copy constructor which puts the copy in a different allocator, such as a request scoped arena
+		HashTable(const HashTable& other, const Allocator& allocator) : allocator(allocator) {
+			this->copy(other);
+		}
+
+		//move constructor, the moved from table may only be assigned to or destroyed
+		HashTable(HashTable&& other) noexcept : allocator(std::move(other.allocator)) {
+			this->hash_function = other.hash_function;
+			this->table_size = other.table_size;
+			this->table = other.table;
+			this->bloom = other.bloom;
+			this->bloom_bits_per_key = other.bloom_bits_per_key;
+			this->bloom_stale = other.bloom_stale;
+			this->bloom_updates = other.bloom_updates;
+
+			other.table = nullptr;
+			other.table_size = 0;
+			other.bloom = nullptr;
 		}
 
 		~HashTable() {
@@ -364,15 +727,89 @@ namespace hash_table {
 			//deallocate existing memory
 			deallocate();
 
-			//take copy table content
-			this->table = other.copy();
+			if constexpr (ALLOCATOR_TRAITS::propagate_on_container_copy_assignment::value) {
+				this->allocator = other.allocator;
+			}
 
-			//copy table size
-			this->table_size = other.table_size;
+			//copy table content, size, hash function and filter
+			this->copy(other);
 
 			return *this;
 		}
 
+		HashTable& operator= (HashTable&& other) noexcept(ALLOCATOR_TRAITS::propagate_on_container_move_assignment::value || ALLOCATOR_TRAITS::is_always_equal::value)
+		{
+			if constexpr (ALLOCATOR_TRAITS::propagate_on_container_move_assignment::value) {
+				std::swap(this->allocator, other.allocator);
+			}
+			else if (this->allocator != other.allocator) {
+				//memory from another allocator can't be taken over, so copy it instead
+				return *this = other;
+			}
+
+			//swap tables so the other table frees our old memory
+			std::swap(this->table, other.table);
+			std::swap(this->table_size, other.table_size);
+			std::swap(this->hash_function, other.hash_function);
+			std::swap(this->bloom, other.bloom);
+			std::swap(this->bloom_bits_per_key, other.bloom_bits_per_key);
+			std::swap(this->bloom_stale, other.bloom_stale);
+			std::swap(this->bloom_updates, other.bloom_updates);
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Deep copy the table, copying ranges of buckets on several threads at once.
+		/// </summary>
+		/// <param name="thread_count">Number of threads to use, 0 uses one per hardware thread.</param>
+		/// <returns>A copy of the table.</returns>
+		HashTable clone(unsigned int thread_count = 0) const {
+			//the copy's bucket array is allocated once up front, each thread fills its own range of it
+			HashTable result(this->hash_function, this->table_size, ALLOCATOR_TRAITS::select_on_container_copy_construction(this->allocator));
+
+			if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+
+			//other allocators, such as pmr resources, don't have to be thread safe so they are copied on one thread
+			if constexpr (!std::is_same_v<Allocator, std::allocator<typename ALLOCATOR_TRAITS::value_type>>) thread_count = 1;
+
+			//don't start threads which would only copy a handful of buckets
+			unsigned long max_threads = this->table_size / MIN_CLONE_BUCKETS;
+			if (thread_count > max_threads) thread_count = (unsigned int)max_threads;
+			if (thread_count == 0) thread_count = 1;
+
+			unsigned long chunk = (this->table_size + thread_count - 1) / thread_count;
+
+			auto copy_range = [this, &result](unsigned long begin, unsigned long end) {
+				for (unsigned long i = begin; i < end; i++) {
+					result.table[i] = result.copy_entry(this->table[i]);
+				}
+			};
+
+			std::vector<std::thread> workers;
+
+			for (unsigned int t = 1; t < thread_count; t++) {
+				unsigned long begin = t * chunk;
+				unsigned long end = begin + chunk < this->table_size ? begin + chunk : this->table_size;
+
+				if (begin < end) workers.push_back(std::thread(copy_range, begin, end));
+			}
+
+			//the calling thread copies the first range
+			copy_range(0, chunk < this->table_size ? chunk : this->table_size);
+
+			for (auto& worker : workers) {
+				worker.join();
+			}
+
+			result.bloom = this->bloom == nullptr ? nullptr : new BloomFilter(*this->bloom);
+			result.bloom_bits_per_key = this->bloom_bits_per_key;
+			result.bloom_stale = this->bloom_stale;
+			result.bloom_updates = this->bloom_updates;
+
+			return result;
+		}
+
 		//insert a key value pair into the table
 		void insert(const KT key, VT value) {
 			//hash the key
@@ -384,7 +821,7 @@ namespace hash_table {
 			//if no entry at that index exists yet
 			if (entry == nullptr) {
 				//create new entry
-				entry = new HashEntry;
+				entry = this->create_entry();
 
 				//add the new key and value to the entry
 				entry->push(key, value);
@@ -396,6 +833,16 @@ namespace hash_table {
 				//if the entry already exists then just add the key value pair
 				entry->push(key, value);
 			}
+
+			if (this->bloom != nullptr) {
+				this->bloom->add(bloom_hash(this->full_hash(key)));
+				this->bloom_updates++;
+
+				//resize the filter once it holds twice the keys it was sized for
+				if (this->bloom->size() > this->bloom->capacity() * 2 && this->bloom_rebuild_allowed()) {
+					this->rebuild_bloom(this->bloom->size() * 2);
+				}
+			}
 		}
 
 		//get a pointer to a value by providing a key
@@ -403,6 +850,11 @@ namespace hash_table {
 			//return value
 			VT* val = nullptr;
 
+			//a negative answer from the filter means the key is not in the table
+			if (this->bloom != nullptr && !this->bloom->may_contain(bloom_hash(this->full_hash(key)))) {
+				return val;
+			}
+
 			//hash the key
 			unsigned long hashed_key = this->hash_function(key, this->table_size);
 
@@ -437,11 +889,141 @@ namespace hash_table {
 			}
 			else {
 				//if no node in the entry contains the value then return false
-				return entry->remove(key);
+				bool removed = entry->remove(key);
+
+				//removed keys stay in the filter, rebuild it once they make up half of its keys
+				if (removed && this->bloom != nullptr) {
+					this->bloom_stale++;
+					this->bloom_updates++;
+
+					if (this->bloom_stale > this->bloom->size() / 2 && this->bloom_rebuild_allowed()) this->rebuild_bloom(this->bloom->capacity());
+				}
+
+				return removed;
 			}
 		}
 
+		/// <summary>
+		/// Remove every key value pair matching a predicate in a single pass over the buckets.
+		/// Buckets which are emptied have their HashEntry freed right away.
+		/// </summary>
+		/// <param name="predicate">Called with each key and value as const references, returns true if the pair should be removed.</param>
+		/// <returns>The number of pairs removed.</returns>
+		template <typename PREDICATE>
+		unsigned long erase_if(PREDICATE predicate) {
+			unsigned long removed = 0;
+
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				HashEntry* entry = this->table[i];
+
+				if (entry == nullptr) continue;
+
+				removed += entry->erase_if(predicate);
+
+				if (entry->head == nullptr) {
+					this->destroy_entry(entry);
+					this->table[i] = nullptr;
+				}
+			}
+
+			//removed keys stay in the filter, rebuild it once they make up half of its keys
+			if (removed > 0 && this->bloom != nullptr) {
+				this->bloom_stale += removed;
+				this->bloom_updates += removed;
+
+				if (this->bloom_stale > this->bloom->size() / 2 && this->bloom_rebuild_allowed()) this->rebuild_bloom(this->bloom->capacity());
+			}
+
+			return removed;
+		}
+
+		/// <summary>
+		/// Free the HashEntry of every empty bucket and shrink the bucket array, moving the existing nodes into the new buckets.
+		/// The array is never grown, and duplicate keys keep their order so get() returns the same value as before.
+		/// </summary>
+		/// <param name="bucket_count">Number of buckets to shrink to, 0 uses one bucket per key value pair.</param>
+		void shrink_to_fit(unsigned long bucket_count = 0) {
+			unsigned long count = 0;
+
+			//free empty entries
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				HashEntry* entry = this->table[i];
+
+				if (entry == nullptr) continue;
+
+				if (entry->head == nullptr) {
+					this->destroy_entry(entry);
+					this->table[i] = nullptr;
+				}
+				else {
+					count += entry->size();
+				}
+			}
+
+			if (bucket_count == 0) bucket_count = count > 0 ? count : 1;
+			if (bucket_count >= this->table_size) return;
+
+			HashEntry** buckets = this->allocate_table(bucket_count);
+
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				HashEntry* entry = this->table[i];
+
+				if (entry == nullptr) continue;
+
+				//relink from the back so the nodes of each key keep their order
+				HashNode* current_node = entry->tail;
+
+				while (current_node != nullptr) {
+					HashNode* previous_node = current_node->front;
+					HashEntry*& bucket = buckets[this->hash_function(current_node->key, bucket_count)];
+
+					if (bucket == nullptr) bucket = this->create_entry();
+					bucket->push_node(current_node);
+
+					current_node = previous_node;
+				}
+
+				//the nodes now belong to the new buckets
+				entry->head = nullptr;
+				entry->tail = nullptr;
+				this->destroy_entry(entry);
+			}
+
+			BUCKET_ALLOCATOR bucket_allocator(this->allocator);
+			std::allocator_traits<BUCKET_ALLOCATOR>::deallocate(bucket_allocator, this->table, this->table_size);
+
+			this->table = buckets;
+			this->table_size = bucket_count;
+		}
+
+		/// <summary>
+		/// Keep a Bloom filter of the keys so that get() can reject most missing keys after reading one cache line.
+		/// The filter is rebuilt to drop removed keys or to grow, which reads every bucket, so a rebuild waits for
+		/// at least one insert or remove per BLOOM_REBUILD_BUCKETS buckets and a large sparse table may run with a fuller filter meanwhile.
+		/// </summary>
+		/// <param name="expected_keys">Number of keys to size the filter for, at least the current size is used.</param>
+		/// <param name="bits_per_key">Filter bits per key, 10 gives roughly a 1% false positive rate.</param>
+		void enable_bloom_filter(unsigned long expected_keys = 0, double bits_per_key = 10) {
+			this->bloom_bits_per_key = bits_per_key;
+			this->rebuild_bloom(expected_keys);
+		}
+
+		/// <summary>
+		/// Stop using the Bloom filter and free it.
+		/// </summary>
+		void disable_bloom_filter() {
+			delete this->bloom;
+			this->bloom = nullptr;
+		}
+
 		
+		/// <summary>
+		/// Return the allocator the table's memory comes from.
+		/// </summary>
+		Allocator get_allocator() const {
+			return this->allocator;
+		}
+
 		/// <summary>
 		/// Return the total number of Key/Value pairs stored in the table.
 		/// </summary>
@@ -463,6 +1045,132 @@ namespace hash_table {
 			return count;
 		}
 
+		/// <summary>
+		/// Return the number of bytes used by the table, not counting allocator overhead.
+		/// </summary>
+		/// <returns>Breakdown of the bytes used.</returns>
+		MemoryUsage memory_usage() const {
+			MemoryUsage usage;
+			usage.bucket_array = this->table_size * sizeof(HashEntry*);
+			usage.bloom_filter = this->bloom == nullptr ? 0 : this->bloom->memory_usage();
+
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				HashEntry* current_entry = this->table[i];
+
+				if (current_entry == nullptr) continue;
+
+				usage.entries += sizeof(HashEntry);
+
+				for (auto node = current_entry->head; node != nullptr; node = node->back) {
+					usage.nodes += sizeof(typename HashEntry::HashNode);
+					usage.out_of_line += out_of_line_bytes(node->key) + out_of_line_bytes(node->value);
+				}
+			}
+
+			return usage;
+		}
+
+		/// <summary>
+		/// Call a function with every key and value, splitting the buckets and any long chain into chunks which are run on a work stealing pool.
+		/// The function is called from several threads at once and must not insert into or remove from the table.
+		/// An exception thrown by the function is rethrown here once every worker has stopped.
+		/// </summary>
+		/// <param name="function">Called with each key and a reference to its value.</param>
+		/// <param name="pool">Pool to run on.</param>
+		template <typename FUNCTION>
+		void parallel_for_each(FUNCTION function, WorkStealingPool& pool = WorkStealingPool::shared()) {
+			auto visit = [&function](HashNode* node, unsigned int) {
+				function((const KT&)node->key, node->value);
+			};
+
+			this->parallel_scan(visit, pool);
+		}
+
+		/// <summary>
+		/// Map every key and value to a result and combine the results, splitting the buckets and any long chain into chunks which are run on a work stealing pool.
+		/// Each worker combines into its own partial result, the partials are combined with init at the end in no particular order,
+		/// so combine must be associative and commutative.
+		/// </summary>
+		/// <param name="init">Starting value of the result.</param>
+		/// <param name="map">Called with each key and value, returns a result.</param>
+		/// <param name="combine">Combines two results into one.</param>
+		/// <param name="pool">Pool to run on.</param>
+		/// <returns>init combined with the result of every key value pair.</returns>
+		template <typename T, typename MAP, typename COMBINE>
+		T parallel_reduce(T init, MAP map, COMBINE combine, WorkStealingPool& pool = WorkStealingPool::shared()) {
+			//partial results on their own cache lines so workers don't slow each other down
+			struct alignas(64) Partial {
+				std::optional<T> value;
+			};
+
+			std::vector<Partial> partials(pool.worker_count());
+
+			auto visit = [&map, &combine, &partials](HashNode* node, unsigned int worker) {
+				std::optional<T>& partial = partials[worker].value;
+
+				if (partial.has_value()) *partial = combine(std::move(*partial), map((const KT&)node->key, (const VT&)node->value));
+				else partial.emplace(map((const KT&)node->key, (const VT&)node->value));
+			};
+
+			this->parallel_scan(visit, pool);
+
+			for (auto& partial : partials) {
+				if (partial.value.has_value()) init = combine(std::move(init), std::move(*partial.value));
+			}
+
+			return init;
+		}
+
+		/// <summary>
+		/// Build an immutable copy of the table which uses a minimal perfect hash for lookups.
+		/// Duplicate keys keep the value which get() currently returns.
+		/// </summary>
+		/// <returns>A FrozenHashTable containing the current contents.</returns>
+		FrozenHashTable<KT, VT> freeze() {
+			std::vector<std::pair<KT, VT>> items;
+			items.reserve(this->size());
+
+			//full hash and node of every node in a chain
+			std::vector<std::pair<unsigned long, HashNode*>> chain;
+
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				HashEntry* current_entry = this->table[i];
+
+				if (current_entry == nullptr) continue;
+
+				HashNode* head = current_entry->head;
+
+				if (head->back == nullptr) {
+					items.push_back(std::pair<KT, VT>(head->key, head->value));
+					continue;
+				}
+
+				//sort the chain by full hash so a duplicate key can only be among the nodes just before it,
+				//the sort is stable so the first node of each key is still the one get() finds
+				chain.clear();
+				for (auto node = head; node != nullptr; node = node->back) {
+					chain.push_back(std::pair<unsigned long, HashNode*>(this->full_hash(node->key), node));
+				}
+
+				std::stable_sort(chain.begin(), chain.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+				for (size_t j = 0; j < chain.size(); j++) {
+					bool duplicate = false;
+
+					for (size_t k = j; k-- > 0 && chain[k].first == chain[j].first;) {
+						if (chain[k].second->key == chain[j].second->key) {
+							duplicate = true;
+							break;
+						}
+					}
+
+					if (!duplicate) items.push_back(std::pair<KT, VT>(chain[j].second->key, chain[j].second->value));
+				}
+			}
+
+			return FrozenHashTable<KT, VT>(items, this->hash_function);
+		}
+
 		/// <summary>
 		/// Print the Hash Table.
 		/// </summary>
@@ -508,4 +1216,16 @@ namespace hash_table {
 			stream << L"+" << rpt_chr(L'-', max_index_length) << L"+" << rpt_chr(L'-', max_key_length) << L"+" << rpt_chr(L'-', max_value_length) << L"+\n";
 		}
 	};
-};
\ No newline at end of file
+
+	namespace pmr {
+		/// <summary>
+		/// A HashTable whose bucket array, entries and nodes come from a std::pmr::memory_resource.
+		/// Long string keys and values still keep their characters on the global heap, std::pmr strings included since nodes copy them
+		/// in with the default resource. Releasing the resource frees the bucket array, entries and nodes, but such a table must still be destroyed.
+		/// </summary>
+		template <typename KT, typename VT>
+		using HashTable = hash_table::HashTable<KT, VT, std::pmr::polymorphic_allocator<std::pair<const KT, VT>>>;
+	};
+};
+
+#include "frozen_hash_table.hpp"
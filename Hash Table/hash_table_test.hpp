@@ -1,5 +1,20 @@
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 #include "hash_table.hpp"
+#include "concurrent_hash_table.hpp"
+#include "lookup_pipeline.hpp"
+#include "cow_hash_table.hpp"
+#include "cuckoo_hash_table.hpp"
+#include "durable_hash_table.hpp"
+#include "expiring_hash_table.hpp"
+#include "hash_multimap.hpp"
+#include "int_hash_table.hpp"
+#include "huge_page_resource.hpp"
+#include "lru_cache.hpp"
+#include "robin_hood_hash_table.hpp"
+#include "string_pool.hpp"
 #include "hash_table_utils.hpp"
 #include "unit_testing.hpp"
 
@@ -12,7 +27,7 @@ namespace hash_table_testing {
 	//random value generator seed (for consistantcy between tests)
 	const int RAND_SEED = 1231548125718923;
 
-	inline void test_functionality() {
+	inline bool test_functionality() {
 		UnitTest test = UnitTest(L"Hash Table Functionality Test");
 
 		//initalize random value seed
@@ -56,8 +71,719 @@ namespace hash_table_testing {
 			return true;
 		}, true);
 
+		test.assert<bool>(L"Frozen table matches the live table.", [&hash_table, &dataset]() {
+			auto frozen = hash_table->freeze();
+
+			for (int i = 0; i < 100; i++) {
+				auto key = get<0>(dataset[i]);
+				auto value = frozen.get(key);
+
+				if (value == nullptr || *value != *hash_table->get(key)) return false;
+			}
+
+			//duplicate keys, and keys which share a full hash and end up in the overflow list
+			HashTable<wstring, wstring> colliding(string_hash_function, 4);
+
+			for (int i = 0; i < 8; i++) {
+				wstring key;
+				for (int block = 0; block < 3; block++) key += (i >> block) & 1 ? L"Ab" : L"BA";
+
+				colliding.insert(key, L"old");
+				colliding.insert(key, L"new");
+			}
+
+			auto frozen_colliding = colliding.freeze();
+
+			bool deduplicated = frozen_colliding.size() == 8 && *frozen_colliding.get(L"AbAbAb") == L"new" && frozen_colliding.get(L"AbAbBB") == nullptr;
+
+			//distinct keys never need the overflow list, even when there are too many for the displacement search to reach every slot
+			vector<pair<unsigned long long, unsigned long long>> items;
+			for (unsigned long long i = 0; i < 200000; i++) {
+				items.push_back(make_pair(i * 2654435761ull, i));
+			}
+
+			FrozenHashTable<unsigned long long, unsigned long long> frozen_large(items, int_hash_function<unsigned long long>);
+
+			bool large_placed = frozen_large.overflow_size() == 0 && *frozen_large.get(199999 * 2654435761ull) == 199999 && frozen_large.get(1) == nullptr;
+
+			return frozen.get(L"does not exist") == nullptr && deduplicated && frozen_colliding.overflow_size() == 8 && large_placed;
+		}, true);
+
+		test.assert<bool>(L"Assigned table is an independent copy.", [&hash_table, &dataset]() {
+			HashTable<wstring, wstring> copy(string_hash_function);
+			copy = *hash_table;
+
+			for (int i = 0; i < 100; i++) {
+				auto key = get<0>(dataset[i]);
+				if (*copy.get(key) != *hash_table->get(key)) return false;
+			}
+
+			copy.remove(get<0>(dataset[0]));
+			return copy.size() == hash_table->size() - 1;
+		}, true);
+
+		test.assert<bool>(L"Cloned and moved tables keep their contents.", []() {
+			//enough buckets for clone(4) to copy on four threads, which needs MIN_CLONE_BUCKETS per thread
+			HashTable<wstring, wstring> table(string_hash_function, 4 * 4096 + 1000);
+
+			for (int i = 0; i < 30000; i++) {
+				table.insert(to_wstring(i), to_wstring(i));
+			}
+
+			//duplicates must keep their order
+			for (int i = 0; i < 30000; i += 7) {
+				table.insert(to_wstring(i), L"newer");
+			}
+
+			HashTable<wstring, wstring> cloned = table.clone(4);
+			HashTable<wstring, wstring> moved(std::move(cloned));
+
+			for (int i = 0; i < 30000; i++) {
+				wstring key = to_wstring(i);
+				wstring* original = table.get(key);
+				wstring* copy = moved.get(key);
+
+				if (copy == nullptr || copy == original || *copy != *original) return false;
+			}
+
+			MemoryUsage original_usage = table.memory_usage();
+			MemoryUsage copy_usage = moved.memory_usage();
+
+			table.remove(L"7");
+
+			return moved.size() == 30000 + 4286 && copy_usage.entries == original_usage.entries && copy_usage.nodes == original_usage.nodes
+				&& *moved.get(L"7") == L"newer" && *table.get(L"7") == L"7";
+		}, true);
+
+		test.assert<bool>(L"Pipelined multi-get matches get.", [&hash_table, &dataset]() {
+			vector<wstring> keys;
+
+			for (int i = 0; i < 100; i++) {
+				keys.push_back(get<0>(dataset[i]));
+			}
+
+			keys.push_back(L"does not exist");
+
+			auto results = LookupPipeline<wstring, wstring>(*hash_table, 8).multi_get(keys);
+
+			for (size_t i = 0; i < keys.size(); i++) {
+				if (results[i] != hash_table->get(keys[i])) return false;
+			}
+
+			return true;
+		}, true);
+
+		test.assert<bool>(L"LRU cache evicts the least recently used entry.", []() {
+			wstring evicted = L"";
+			LruCache<wstring, wstring> cache(string_hash_function, 2, [&evicted](const wstring& key, const wstring&) {
+				evicted = key;
+			});
+
+			cache.insert(L"a", L"1");
+			cache.insert(L"b", L"2");
+			cache.get(L"a");
+			cache.insert(L"c", L"3");
+
+			return evicted == L"b" && cache.get(L"b") == nullptr && *cache.get(L"a") == L"1" && cache.size() == 2
+				&& cache.hits() == 2 && cache.misses() == 1 && cache.evictions() == 1;
+		}, true);
+
+		test.assert<bool>(L"Expired entries are removed.", []() {
+			ExpiringHashTable<wstring, wstring> table(string_hash_function);
+			auto now = chrono::steady_clock::now();
+
+			table.insert(L"short", L"1", chrono::milliseconds(10), now);
+			table.insert(L"long", L"2", chrono::seconds(10), now);
+			table.insert(L"forever", L"3");
+
+			bool swept = table.expire(now + chrono::milliseconds(20)) == 1 && table.size() == 2;
+			bool lazy = table.get(L"long", now + chrono::seconds(20)) == nullptr && table.size() == 1;
+
+			//far off timers must not make expire() step through every millisecond in between
+			table.insert(L"hour", L"4", chrono::hours(1), now);
+			table.insert(L"year", L"5", chrono::hours(24 * 365), now);
+			table.insert(L"decade", L"6", chrono::hours(24 * 3650), now);
+
+			bool far = table.expire(now + chrono::minutes(59)) == 0 && table.expire(now + chrono::minutes(61)) == 1
+				&& table.expire(now + chrono::hours(24 * 364)) == 0 && table.expire(now + chrono::hours(24 * 366)) == 1
+				&& table.get(L"decade", now + chrono::hours(24 * 366)) != nullptr && table.expire(now + chrono::hours(24 * 3651)) == 1;
+
+			return swept && lazy && far && *table.get(L"forever", now + chrono::hours(24)) == L"3";
+		}, true);
+
+		test.assert<bool>(L"Multimap groups values by key.", []() {
+			HashMultiMap<wstring, wstring> table(string_hash_function);
+
+			table.insert(L"key", L"1");
+			table.insert(L"key", L"2");
+			table.insert(L"key", L"3");
+			table.insert(L"other", L"4");
+
+			auto range = table.equal_range(L"key");
+			bool grouped = range.second - range.first == 3 && range.first[2] == L"3" && table.key_count() == 2;
+
+			bool erased = table.erase_one(L"key", L"2") && table.count(L"key") == 2 && table.erase(L"key") == 2;
+
+			return grouped && erased && table.size() == 1 && table.equal_range(L"key").first == nullptr;
+		}, true);
+
+		test.assert<bool>(L"Cuckoo table grows and finds every key.", []() {
+			CuckooHashTable<wstring, wstring> table(string_hash_function, 8);
+
+			for (int i = 0; i < 1000; i++) {
+				table.insert(to_wstring(i), to_wstring(i * 2));
+			}
+
+			for (int i = 0; i < 1000; i += 2) {
+				if (!table.remove(to_wstring(i))) return false;
+			}
+
+			for (int i = 0; i < 1000; i++) {
+				auto value = table.get(to_wstring(i));
+
+				if ((value != nullptr) != (i % 2 == 1)) return false;
+				if (value != nullptr && *value != to_wstring(i * 2)) return false;
+			}
+
+			return table.size() == 500;
+		}, true);
+
+		test.assert<bool>(L"Cuckoo stash stays bounded as the table fills.", []() {
+			CuckooHashTable<wstring, wstring> table(string_hash_function, 8);
+
+			size_t largest_stash = 0;
+			double highest_load = 0;
+
+			for (int i = 0; i < 20000; i++) {
+				if (!table.insert(to_wstring(i), to_wstring(i))) return false;
+
+				if (table.stash_size() > largest_stash) largest_stash = table.stash_size();
+				if (table.load_factor() > highest_load) highest_load = table.load_factor();
+			}
+
+			return largest_stash <= CuckooHashTable<wstring, wstring>::STASH_SIZE && highest_load > 0.9 && *table.get(L"19999") == L"19999";
+		}, true);
+
+		test.assert<bool>(L"Cuckoo table rejects keys with the same hash once their buckets and the stash are full.", []() {
+			CuckooHashTable<wstring, wstring> table(string_hash_function, 8);
+
+			//"Ab" and "BA" hash the same, so every string made of four of them collides
+			vector<wstring> keys;
+			for (int i = 0; i < 16; i++) {
+				wstring key;
+				for (int block = 0; block < 4; block++) key += (i >> block) & 1 ? L"Ab" : L"BA";
+				keys.push_back(key);
+			}
+
+			//two buckets of four slots and a stash of four
+			for (int i = 0; i < 12; i++) {
+				if (!table.insert(keys[i], keys[i])) return false;
+			}
+
+			for (int i = 12; i < 16; i++) {
+				if (table.insert(keys[i], keys[i])) return false;
+			}
+
+			for (int i = 0; i < 16; i++) {
+				auto value = table.get(keys[i]);
+				if ((value != nullptr) != (i < 12) || (value != nullptr && *value != keys[i])) return false;
+			}
+
+			return table.size() == 12 && table.stash_size() == 4 && table.load_factor() == 12.0 / 8 && table.remove(keys[0]) && table.insert(keys[12], L"");
+		}, true);
+
+		test.assert<bool>(L"Robin Hood table shifts entries back on remove.", []() {
+			RobinHoodHashTable<wstring, wstring> table(string_hash_function, 8);
+
+			for (int i = 0; i < 1000; i++) {
+				table.insert(to_wstring(i), to_wstring(i * 2));
+			}
+
+			for (int i = 0; i < 1000; i += 2) {
+				if (!table.remove(to_wstring(i))) return false;
+			}
+
+			for (int i = 0; i < 1000; i++) {
+				auto value = table.get(to_wstring(i));
+
+				if ((value != nullptr) != (i % 2 == 1)) return false;
+				if (value != nullptr && *value != to_wstring(i * 2)) return false;
+			}
+
+			return table.size() == 500 && table.get(L"does not exist") == nullptr;
+		}, true);
+
+		test.assert<bool>(L"Robin Hood table keeps hundreds of keys with the same hash without growing.", []() {
+			RobinHoodHashTable<wstring, wstring> table(string_hash_function, 1024);
+
+			//"Ab" and "BA" hash the same, so all 512 strings made of nine of them collide
+			vector<wstring> keys;
+			for (int i = 0; i < 512; i++) {
+				wstring key;
+				for (int block = 0; block < 9; block++) key += (i >> block) & 1 ? L"Ab" : L"BA";
+				keys.push_back(key);
+				table.insert(key, key);
+			}
+
+			for (auto& key : keys) {
+				auto value = table.get(key);
+				if (value == nullptr || *value != key) return false;
+			}
+
+			for (int i = 0; i < 512; i += 2) {
+				if (!table.remove(keys[i])) return false;
+			}
+
+			return table.size() == 256 && table.load_factor() > 0.1 && table.get(keys[0]) == nullptr && *table.get(keys[1]) == keys[1];
+		}, true);
+
+		test.assert<bool>(L"Snapshots are isolated from later writes.", []() {
+			CowHashTable<wstring, wstring> table(string_hash_function);
+
+			table.insert(L"a", L"1");
+			table.insert(L"b", L"2");
+
+			auto snapshot = table.snapshot();
+
+			table.insert(L"c", L"3");
+			table.remove(L"a");
+			snapshot.insert(L"d", L"4");
+
+			bool original = table.get(L"a") == nullptr && *table.get(L"c") == L"3" && table.get(L"d") == nullptr && table.size() == 2;
+			bool copied = *snapshot.get(L"a") == L"1" && snapshot.get(L"c") == nullptr && *snapshot.get(L"d") == L"4" && snapshot.size() == 3;
+
+			//a table deep enough for two branch levels, written by two threads after sharing every node
+			CowHashTable<wstring, wstring> large(string_hash_function, 8192);
+
+			for (int i = 0; i < 2000; i++) {
+				large.insert(to_wstring(i), L"old");
+			}
+
+			auto shared = large.snapshot();
+
+			thread writer([&shared]() {
+				for (int i = 0; i < 2000; i += 2) shared.remove(to_wstring(i));
+			});
+
+			for (int i = 0; i < 2000; i += 3) {
+				large.remove(to_wstring(i));
+				large.insert(to_wstring(i), L"new");
+			}
+
+			writer.join();
+
+			bool isolated = large.size() == 2000 && shared.size() == 1000;
+			for (int i = 0; i < 2000; i++) {
+				const wstring* value = large.get(to_wstring(i));
+				isolated = isolated && value != nullptr && *value == (i % 3 == 0 ? L"new" : L"old");
+				isolated = isolated && (shared.get(to_wstring(i)) == nullptr) == (i % 2 == 0);
+			}
+
+			return original && copied && isolated;
+		}, true);
+
+		test.assert<bool>(L"Concurrent table grows while threads insert.", []() {
+			ConcurrentHashTable<wstring, wstring> table(string_hash_function, 16);
+			vector<thread> workers;
+
+			for (int t = 0; t < 4; t++) {
+				workers.push_back(thread([&table, t]() {
+					for (int i = 0; i < 2500; i++) {
+						table.insert(to_wstring(t) + L":" + to_wstring(i), to_wstring(i));
+					}
+				}));
+			}
+
+			for (auto& worker : workers) {
+				worker.join();
+			}
+
+			for (int t = 0; t < 4; t++) {
+				for (int i = 0; i < 2500; i++) {
+					auto value = table.get(to_wstring(t) + L":" + to_wstring(i));
+					if (!value || *value != to_wstring(i)) return false;
+				}
+			}
+
+			return table.size() == 10000 && table.bucket_count() > 16;
+		}, true);
+
+		test.assert<bool>(L"Concurrent lookups find every key while the table grows.", []() {
+			ConcurrentHashTable<wstring, wstring> table(string_hash_function, 16);
+
+			for (int i = 0; i < 1000; i++) {
+				table.insert(L"old:" + to_wstring(i), to_wstring(i));
+			}
+
+			size_t buckets = table.bucket_count();
+			atomic<bool> inserting{ true };
+			atomic<bool> found{ true };
+			vector<thread> workers;
+
+			//readers keep looking up the existing keys while the writers force several resizes
+			for (int t = 0; t < 2; t++) {
+				workers.push_back(thread([&]() {
+					do {
+						for (int i = 0; i < 1000; i++) {
+							auto value = table.get(L"old:" + to_wstring(i));
+							if (!value || *value != to_wstring(i)) found = false;
+						}
+					} while (inserting.load());
+				}));
+			}
+
+			vector<thread> writers;
+			for (int t = 0; t < 2; t++) {
+				writers.push_back(thread([&table, t]() {
+					for (int i = 0; i < 5000; i++) {
+						table.insert(to_wstring(t) + L":" + to_wstring(i), to_wstring(i));
+					}
+				}));
+			}
+
+			for (auto& writer : writers) {
+				writer.join();
+			}
+
+			inserting = false;
+
+			for (auto& worker : workers) {
+				worker.join();
+			}
+
+			return found.load() && table.size() == 11000 && table.bucket_count() >= buckets * 8;
+		}, true);
+
+		test.assert<bool>(L"Buckets come from the hash function called with the bucket count.", []() {
+			//a hash which masks by size - 1, it would only fill even buckets if it were called with ULONG_MAX first
+			auto mask_hash = [](wstring key, unsigned long size) { return (unsigned long)stoul(key) & (size - 1); };
+
+			HashTable<wstring, wstring> table(mask_hash, 64), single(mask_hash, 64);
+			single.insert(L"0", L"0");
+
+			for (int i = 0; i < 64; i++) {
+				table.insert(to_wstring(i), to_wstring(i));
+			}
+
+			//one entry per bucket, with or without a Bloom filter
+			bool spread = table.memory_usage().entries == 64 * single.memory_usage().entries;
+
+			table.enable_bloom_filter(64);
+			table.remove(L"1");
+
+			return spread && table.get(L"1") == nullptr && *table.get(L"63") == L"63" && *table.get(L"62") == L"62";
+		}, true);
+
+		test.assert<bool>(L"Bloom filter keeps every key and rejects missing ones.", []() {
+			HashTable<wstring, wstring> table(string_hash_function, 64);
+
+			for (int i = 0; i < 500; i++) {
+				table.insert(to_wstring(i), to_wstring(i));
+			}
+
+			//insert past the sized capacity and remove enough keys to force rebuilds
+			table.enable_bloom_filter(100);
+
+			for (int i = 500; i < 2000; i++) {
+				table.insert(to_wstring(i), to_wstring(i));
+			}
+
+			for (int i = 0; i < 2000; i += 2) {
+				if (!table.remove(to_wstring(i))) return false;
+			}
+
+			for (int i = 0; i < 4000; i++) {
+				auto value = table.get(to_wstring(i));
+
+				if ((value != nullptr) != (i < 2000 && i % 2 == 1)) return false;
+			}
+
+			//a large sparse table delays its rebuilds but never loses a key
+			HashTable<wstring, wstring> sparse(string_hash_function, 1 << 20);
+			sparse.enable_bloom_filter(4);
+
+			for (int round = 0; round < 100; round++) {
+				for (int i = 0; i < 20; i++) sparse.insert(to_wstring(round * 20 + i), L"1");
+				for (int i = 0; i < 20; i += 2) sparse.remove(to_wstring(round * 20 + i));
+			}
+
+			for (int i = 0; i < 2000; i++) {
+				if ((sparse.get(to_wstring(i)) != nullptr) != (i % 2 == 1)) return false;
+			}
+
+			HashTable<wstring, wstring> copy = table;
+			table.disable_bloom_filter();
+
+			return *copy.get(L"1999") == L"1999" && copy.get(L"1998") == nullptr && *table.get(L"1") == L"1";
+		}, true);
+
+		test.assert<bool>(L"Allocator aware tables use arena and huge page memory.", []() {
+			static char buffer[64 * 1024];
+			std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+			hash_table::pmr::HashTable<wstring, wstring> table(string_hash_function, 64, &arena);
+
+			for (int i = 0; i < 200; i++) {
+				table.insert(to_wstring(i), to_wstring(i));
+			}
+
+			table.remove(L"0");
+
+			//the nodes must live inside the arena's buffer
+			char* node = (char*)table.get(L"199");
+			bool in_arena = node >= buffer && node < buffer + sizeof(buffer) && table.get(L"0") == nullptr && table.size() == 199;
+
+			//copy the table out of the arena into a bucket array large enough to be mapped on huge pages
+			HugePageResource huge_pages;
+			hash_table::pmr::HashTable<wstring, wstring> copy(string_hash_function, 1 << 20, &huge_pages);
+
+			for (int i = 1; i < 200; i++) {
+				copy.insert(to_wstring(i), *table.get(to_wstring(i)));
+			}
+
+			auto moved = std::move(copy);
+
+			return in_arena && moved.size() == 199 && *moved.get(L"42") == L"42" && moved.get_allocator().resource() == &huge_pages;
+		}, true);
+
+		test.assert<bool>(L"Memory usage counts buckets, entries, nodes and long strings.", []() {
+			HashTable<wstring, wstring> table(string_hash_function, 16);
+
+			table.insert(L"a", L"1");
+			table.insert(L"b", L"2");
+			table.insert(wstring(100, L'c'), wstring(200, L'3'));
+
+			MemoryUsage usage = table.memory_usage();
+			size_t node_size = sizeof(HashTable<wstring, wstring>::HashEntry::HashNode);
+
+			//only the long key and value are stored outside their nodes
+			return usage.bucket_array == 16 * sizeof(void*) && usage.nodes == 3 * node_size
+				&& usage.entries >= sizeof(HashTable<wstring, wstring>::HashEntry) && usage.entries <= 3 * sizeof(HashTable<wstring, wstring>::HashEntry)
+				&& usage.out_of_line >= 302 * sizeof(wchar_t) && usage.bloom_filter == 0
+				&& usage.total() == usage.bucket_array + usage.entries + usage.nodes + usage.out_of_line;
+		}, true);
+
+		test.assert<bool>(L"erase_if and shrink_to_fit release memory and keep the rest.", []() {
+			HashTable<wstring, wstring> table(string_hash_function, 4096);
+
+			for (int i = 0; i < 1000; i++) {
+				table.insert(to_wstring(i), to_wstring(i));
+			}
+
+			table.insert(L"7", L"newer");
+
+			unsigned long removed = table.erase_if([](const wstring& key, const wstring&) { return stoi(key) % 4 != 3; });
+			size_t entries_before = table.memory_usage().entries;
+
+			//remove the rest of a bucket one key at a time so its HashEntry is left empty
+			table.remove(L"3");
+
+			table.shrink_to_fit();
+			MemoryUsage usage = table.memory_usage();
+
+			for (int i = 0; i < 1000; i++) {
+				if ((table.get(to_wstring(i)) != nullptr) != (i % 4 == 3 && i != 3)) return false;
+			}
+
+			//the newest duplicate must still be the one found
+			return removed == 750 && *table.get(L"7") == L"newer" && table.size() == 250
+				&& usage.bucket_array == 250 * sizeof(void*) && usage.entries <= entries_before;
+		}, true);
+
+		test.assert<bool>(L"Interned strings are stored once and compare by handle.", []() {
+			StringPool pool;
+			HashTable<InternedString, InternedString> table(interned_hash_function, 64);
+
+			for (int i = 0; i < 1000; i++) {
+				table.insert(pool.intern(L"key " + to_wstring(i % 100)), pool.intern(L"value " + to_wstring(i % 10)));
+			}
+
+			InternedString key = pool.find(L"key 42");
+			auto value = table.get(key);
+
+			wstringstream printed;
+			printed << *value;
+
+			//lookups with text that was never interned must not grow the pool
+			return pool.size() == 110 && key == pool.intern(L"key 42") && value != nullptr && printed.str() == L"value 2"
+				&& value->length() == 7 && pool.find(L"missing").empty() && table.get(pool.find(L"missing")) == nullptr && pool.size() == 110;
+		}, true);
+
+		test.assert<bool>(L"Durable table recovers from its log, a torn tail and a snapshot, and rejects a damaged snapshot.", []() {
+			string path = (filesystem::temp_directory_path() / "hash_table_durable_test").string();
+			filesystem::remove(path + ".log");
+			filesystem::remove(path + ".snapshot");
+
+			auto matches = [](DurableHashTable<wstring, wstring>& table) {
+				for (int i = 0; i < 300; i++) {
+					auto value = table.get(to_wstring(i));
+					if ((value != nullptr) != (i % 3 != 0)) return false;
+				}
+
+				//duplicates must come back in the same order
+				return table.size() == 201 && *table.get(L"1") == L"newer";
+			};
+
+			bool recovered, torn, compacted, rejected;
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 16);
+				if (!table.is_open()) return false;
+
+				for (int i = 0; i < 300; i++) table.insert(to_wstring(i), to_wstring(i));
+				for (int i = 0; i < 300; i += 3) table.remove(to_wstring(i));
+				table.insert(L"1", L"newer");
+			}
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 16);
+				recovered = matches(table);
+			}
+
+			//simulate a crash part way through writing a record
+			{
+				LogFile log;
+				log.open(path + ".log");
+				log.append("\x40\0\0\0garbage", 11);
+			}
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 16);
+				torn = matches(table);
+
+				table.compact();
+				table.insert(L"extra", L"1");
+				table.remove(L"extra");
+			}
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 16);
+				compacted = matches(table) && table.get(L"extra") == nullptr;
+			}
+
+			//a snapshot cut short must not load as a prefix, and the closed table must not buffer writes
+			filesystem::resize_file(path + ".snapshot", filesystem::file_size(path + ".snapshot") - 3);
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 16);
+				rejected = !table.is_open() && table.size() == 0 && !table.insert(L"extra", L"1") && table.get(L"extra") == nullptr;
+			}
+
+			filesystem::remove(path + ".log");
+			filesystem::remove(path + ".snapshot");
+
+			//a partial group waits for more operations, unless its oldest record has waited commit_interval
+			bool buffered, deadline;
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 1000);
+				table.insert(L"a", L"1");
+				buffered = filesystem::file_size(path + ".log") == 16;
+			}
+
+			filesystem::remove(path + ".log");
+
+			{
+				DurableHashTable<wstring, wstring> table(string_hash_function, path, 64, 1000, 0, chrono::milliseconds(0));
+				table.insert(L"a", L"1");
+				deadline = filesystem::file_size(path + ".log") > 16;
+			}
+
+			filesystem::remove(path + ".log");
+
+			return recovered && torn && compacted && rejected && buffered && deadline;
+		}, true);
+
+		test.assert<bool>(L"Parallel for_each and reduce visit every pair once, even with one long chain.", []() {
+			WorkStealingPool pool(4);
+
+			//half of the keys share bucket 0 so the first chunk is far slower than the rest
+			HashTable<unsigned long, unsigned long> table([](unsigned long key, unsigned long size) { return key % 2 == 0 ? 0 : key % size; }, 16384);
+
+			for (unsigned long i = 0; i < 20000; i++) {
+				table.insert(i, i);
+			}
+
+			table.parallel_for_each([](const unsigned long&, unsigned long& value) { value *= 2; }, pool);
+
+			unsigned long long sum = table.parallel_reduce<unsigned long long>(0,
+				[](const unsigned long&, const unsigned long& value) { return (unsigned long long)value; },
+				[](unsigned long long a, unsigned long long b) { return a + b; }, pool);
+
+			unsigned long count = table.parallel_reduce<unsigned long>(0,
+				[](const unsigned long&, const unsigned long&) { return 1ul; },
+				[](unsigned long a, unsigned long b) { return a + b; }, pool);
+
+			//the long chain must be shared, with a slow function no thread should visit most of it
+			mutex lock;
+			unordered_map<thread::id, unsigned long> visits;
+
+			table.parallel_for_each([&lock, &visits](const unsigned long& key, unsigned long&) {
+				if (key % 2 != 0) return;
+
+				this_thread::sleep_for(chrono::microseconds(20));
+
+				lock_guard<mutex> guard(lock);
+				visits[this_thread::get_id()]++;
+			}, pool);
+
+			unsigned long busiest = 0;
+			for (auto& visit : visits) {
+				if (visit.second > busiest) busiest = visit.second;
+			}
+
+			//an exception from any worker reaches the caller after the others have stopped
+			bool rethrown = false;
+			try {
+				table.parallel_for_each([](const unsigned long& key, unsigned long&) {
+					if (key == 12345) throw runtime_error("stop");
+				}, pool);
+			}
+			catch (const runtime_error&) {
+				rethrown = true;
+			}
+
+			return sum == 2ull * 19999 * 20000 / 2 && count == table.size() && busiest < 10000 * 3 / 4 && rethrown;
+		}, true);
+
+		test.assert<bool>(L"Integer table and HashSet store, replace and remove keys.", []() {
+			IntHashTable<unsigned long long, unsigned long long> table(8);
+			HashSet<unsigned long long> set(8);
+
+			for (unsigned long long i = 0; i < 10000; i++) {
+				table.insert(i * 7919, i);
+				set.insert(i * 7919);
+			}
+
+			table.insert(7919, 42);
+
+			for (unsigned long long i = 0; i < 10000; i += 2) {
+				if (!table.remove(i * 7919) || !set.remove(i * 7919)) return false;
+			}
+
+			for (unsigned long long i = 0; i < 10000; i++) {
+				auto value = table.get(i * 7919);
+
+				if ((value != nullptr) != (i % 2 == 1) || set.contains(i * 7919) != (i % 2 == 1)) return false;
+				if (value != nullptr && *value != (i == 1 ? 42 : i)) return false;
+			}
+
+			//a set of integers given its own hash function uses it
+			static unsigned long hashed = 0;
+			HashSet<int> custom([](int key, unsigned long size) { hashed++; return (unsigned long)key % size; });
+
+			for (int i = 0; i < 100; i++) custom.insert(i);
+
+			bool custom_hashed = hashed >= 100 && custom.contains(99) && !custom.contains(100);
+
+			//the empty key is reserved
+			return custom_hashed && table.size() == 5000 && set.size() == 5000 && !set.insert(7919) && !table.insert(ULLONG_MAX, 1) && table.get(ULLONG_MAX) == nullptr;
+		}, true);
+
 		//print results
 		test.log_results();
+
+		return test.passed();
 	}
 
 	inline void test_performance() {
@@ -86,6 +812,9 @@ namespace hash_table_testing {
 				return true;
 			}, true);
 
+			MemoryUsage usage = hash_table->memory_usage();
+			wcout << L"  " << size << L" items: " << (double)usage.total() / size << L" bytes per entry, peak RSS " << peak_rss_bytes() / 1024 << L"KB" << endl;
+
 			test.assert<bool>(L"Remove " + to_wstring(size) + L" items.", [&hash_table, &dataset, &size]() {
 				remove_items(hash_table, dataset, size);
 				return true;
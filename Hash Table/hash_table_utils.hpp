@@ -2,6 +2,16 @@
 #include "hash_table.hpp"
 #include "unit_testing.hpp"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
 namespace hash_table_utils {
 	using namespace std;
 	using namespace hash_table;
@@ -68,4 +78,24 @@ namespace hash_table_utils {
 			table->remove(get<0>(*(dataset + i)));
 		}
 	}
+
+	//returns the peak resident set size of the process in bytes
+	inline size_t peak_rss_bytes() {
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+
+		return counters.PeakWorkingSetSize;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+#if defined(__APPLE__)
+		return (size_t)usage.ru_maxrss;
+#else
+		//linux reports kilobytes
+		return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+	}
 }
\ No newline at end of file
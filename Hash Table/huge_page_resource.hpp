@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace hash_table {
+	/// <summary>
+	/// A memory resource which maps large allocations, such as the bucket array of a big table, straight from the OS on huge pages
+	/// so that they need far fewer TLB entries. Smaller allocations (entries and nodes) are passed to an upstream resource.
+	/// Reserved huge pages are used when the system has them, otherwise transparent huge pages are requested with madvise.
+	/// </summary>
+	class HugePageResource : public std::pmr::memory_resource
+	{
+	public:
+		/// <summary>
+		/// Size of a huge page, large allocations are rounded up to and aligned on this size.
+		/// </summary>
+		static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	private:
+		//resource used for allocations below the threshold
+		std::pmr::memory_resource* upstream;
+
+		//smallest allocation which is mapped on huge pages
+		size_t threshold;
+
+		/// <summary>
+		/// Check if an allocation is mapped on huge pages, the same answer is given when it is freed.
+		/// </summary>
+		bool is_huge(size_t bytes, size_t alignment) const {
+			return bytes >= this->threshold && alignment <= HUGE_PAGE_SIZE;
+		}
+
+		/// <summary>
+		/// Round a size up to a whole number of huge pages.
+		/// </summary>
+		static size_t round_up(size_t bytes) {
+			return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		}
+
+	public:
+		/// <summary>
+		/// Create a HugePageResource.
+		/// </summary>
+		/// <param name="threshold">Smallest allocation in bytes which is mapped on huge pages.</param>
+		/// <param name="upstream">Resource used for smaller allocations.</param>
+		HugePageResource(size_t threshold = HUGE_PAGE_SIZE, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) {
+			this->threshold = threshold == 0 ? 1 : threshold;
+			this->upstream = upstream;
+		}
+
+		HugePageResource(const HugePageResource&) = delete;
+		HugePageResource& operator= (const HugePageResource&) = delete;
+
+		/// <summary>
+		/// Return the resource used for smaller allocations.
+		/// </summary>
+		std::pmr::memory_resource* upstream_resource() const {
+			return this->upstream;
+		}
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override {
+			if (!this->is_huge(bytes, alignment)) return this->upstream->allocate(bytes, alignment);
+
+			size_t length = round_up(bytes);
+
+#if defined(_WIN32)
+			void* memory = nullptr;
+
+			//large pages need the "lock pages in memory" privilege, fall back to normal pages without it
+			size_t large_page = GetLargePageMinimum();
+			if (large_page != 0 && HUGE_PAGE_SIZE % large_page == 0) {
+				memory = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			}
+
+			if (memory == nullptr) memory = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			if (memory == nullptr) throw std::bad_alloc();
+
+			return memory;
+#else
+#if defined(MAP_HUGETLB)
+			//reserved huge pages, this fails unless vm.nr_hugepages has pages free
+			void* memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED) return memory;
+#endif
+
+			//map an extra huge page so the mapping can be trimmed to start on a huge page boundary
+			void* mapped = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapped == MAP_FAILED) throw std::bad_alloc();
+
+			uintptr_t start = (uintptr_t)mapped;
+			uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+			if (aligned > start) munmap(mapped, aligned - start);
+			if (start + HUGE_PAGE_SIZE > aligned) munmap((void*)(aligned + length), start + HUGE_PAGE_SIZE - aligned);
+
+#if defined(MADV_HUGEPAGE)
+			//ask for transparent huge pages instead
+			madvise((void*)aligned, length, MADV_HUGEPAGE);
+#endif
+
+			return (void*)aligned;
+#endif
+		}
+
+		void do_deallocate(void* memory, size_t bytes, size_t alignment) override {
+			if (!this->is_huge(bytes, alignment)) {
+				this->upstream->deallocate(memory, bytes, alignment);
+				return;
+			}
+
+#if defined(_WIN32)
+			VirtualFree(memory, 0, MEM_RELEASE);
+#else
+			munmap(memory, round_up(bytes));
+#endif
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	};
+};
@@ -0,0 +1,454 @@
+#pragma once
+
+#include <climits>
+#include <limits>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// Hashing function for integer keys, usable with HashTable and HashSet.
+	/// </summary>
+	template <typename KT>
+	unsigned long int_hash_function(KT key, unsigned long size) {
+		static_assert(std::is_integral_v<KT>, "int_hash_function needs an integral key");
+
+		return (unsigned long)(mix_hash((unsigned long long)key) % size);
+	}
+
+	/// <summary>
+	/// An open addressing Hash Table for integer keys using linear probing.
+	/// Keys are stored inline next to their values with one reserved key value marking empty slots,
+	/// so there are no nodes, no per slot metadata and a lookup usually reads a single cache line.
+	/// remove() shifts the following entries back instead of leaving tombstones.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key, must be integral.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class IntHashTable
+	{
+		static_assert(std::is_integral_v<KT>, "IntHashTable needs an integral key");
+
+	public:
+		/// <summary>
+		/// A Key/Value pair stored in the slot array.
+		/// </summary>
+		struct Slot {
+			KT key;
+			VT value;
+		};
+
+	private:
+		//the table grows once more than this fraction of the slots are used
+		static constexpr double MAX_LOAD_FACTOR = 0.75;
+
+		//Key/Value pairs, capacity is always a power of two
+		Slot* slots;
+		size_t capacity;
+
+		//number of Key/Value pairs stored
+		unsigned long count = 0;
+
+		//key marking an empty slot, it can't be stored in the table
+		KT empty_key;
+
+		/// <summary>
+		/// Get the ideal slot of a key.
+		/// </summary>
+		size_t home_of(KT key) const {
+			return (size_t)mix_hash((unsigned long long)key) & (this->capacity - 1);
+		}
+
+		/// <summary>
+		/// Find the slot index of a key.
+		/// </summary>
+		/// <returns>The index of the slot, capacity if the key is not in the table.</returns>
+		size_t find_index(KT key) const {
+			if (key == this->empty_key) return this->capacity;
+
+			size_t mask = this->capacity - 1;
+
+			for (size_t index = this->home_of(key);; index = (index + 1) & mask) {
+				if (this->slots[index].key == key) return index;
+				if (this->slots[index].key == this->empty_key) return this->capacity;
+			}
+		}
+
+		/// <summary>
+		/// Allocate a slot array with every slot empty.
+		/// </summary>
+		Slot* allocate_slots(size_t size) {
+			Slot* new_slots = new Slot[size];
+
+			for (size_t i = 0; i < size; i++) {
+				new_slots[i].key = this->empty_key;
+			}
+
+			return new_slots;
+		}
+
+		/// <summary>
+		/// Move every entry into a slot array of a new size.
+		/// </summary>
+		void resize(size_t new_capacity) {
+			Slot* old_slots = this->slots;
+			size_t old_capacity = this->capacity;
+
+			this->slots = this->allocate_slots(new_capacity);
+			this->capacity = new_capacity;
+
+			size_t mask = this->capacity - 1;
+
+			for (size_t i = 0; i < old_capacity; i++) {
+				if (old_slots[i].key == this->empty_key) continue;
+
+				size_t index = this->home_of(old_slots[i].key);
+				while (this->slots[index].key != this->empty_key) index = (index + 1) & mask;
+
+				this->slots[index].key = old_slots[i].key;
+				this->slots[index].value = std::move(old_slots[i].value);
+			}
+
+			delete[] old_slots;
+		}
+
+	public:
+		/// <summary>
+		/// Create an IntHashTable.
+		/// </summary>
+		/// <param name="size">Expected number of entries.</param>
+		/// <param name="empty_key">Key value reserved to mark empty slots.</param>
+		IntHashTable(unsigned long size = 128, KT empty_key = std::numeric_limits<KT>::max()) {
+			this->empty_key = empty_key;
+
+			//round the capacity up to a power of two large enough for size entries
+			this->capacity = 8;
+			while (this->capacity * MAX_LOAD_FACTOR < size) {
+				this->capacity *= 2;
+			}
+
+			slots = this->allocate_slots(this->capacity);
+		}
+
+		IntHashTable(const IntHashTable&) = delete;
+		IntHashTable& operator= (const IntHashTable&) = delete;
+
+		~IntHashTable() {
+			delete[] this->slots;
+		}
+
+		/// <summary>
+		/// Insert a value, replacing the value of an existing key.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		/// <returns>False if the key is the reserved empty key and was not inserted.</returns>
+		bool insert(KT key, VT value) {
+			if (key == this->empty_key) return false;
+
+			size_t index = this->find_index(key);
+
+			if (index != this->capacity) {
+				this->slots[index].value = std::move(value);
+				return true;
+			}
+
+			if (this->count + 1 > this->capacity * MAX_LOAD_FACTOR) {
+				this->resize(this->capacity * 2);
+			}
+
+			size_t mask = this->capacity - 1;
+
+			index = this->home_of(key);
+			while (this->slots[index].key != this->empty_key) index = (index + 1) & mask;
+
+			this->slots[index].key = key;
+			this->slots[index].value = std::move(value);
+
+			this->count++;
+			return true;
+		}
+
+		/// <summary>
+		/// Get a pointer to the value stored by a given key.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>Pointer to the value, nullptr if the key is not in the table.</returns>
+		VT* get(KT key) {
+			size_t index = this->find_index(key);
+
+			return index == this->capacity ? nullptr : &this->slots[index].value;
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the table, shifting the following entries back.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			size_t index = this->find_index(key);
+
+			if (index == this->capacity) return false;
+
+			size_t mask = this->capacity - 1;
+
+			//move back every following entry whose home is not between the freed slot and its current slot
+			for (size_t next = (index + 1) & mask; this->slots[next].key != this->empty_key; next = (next + 1) & mask) {
+				size_t home = this->home_of(this->slots[next].key);
+
+				bool stays = index <= next ? (home > index && home <= next) : (home > index || home <= next);
+				if (stays) continue;
+
+				this->slots[index].key = this->slots[next].key;
+				this->slots[index].value = std::move(this->slots[next].value);
+				index = next;
+			}
+
+			//reset the freed slot so the removed value releases its memory
+			this->slots[index].key = this->empty_key;
+			this->slots[index].value = VT();
+
+			this->count--;
+			return true;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Return the fraction of slots which are in use.
+		/// </summary>
+		double load_factor() const {
+			return (double)this->count / (double)this->capacity;
+		}
+
+		/// <summary>
+		/// Return the number of bytes used by the slot array.
+		/// </summary>
+		size_t memory_usage() const {
+			return this->capacity * sizeof(Slot);
+		}
+
+		/// <summary>
+		/// Print every Key/Value pair, one per line.
+		/// </summary>
+		/// <param name="stream">Stream to print to.</param>
+		void print(std::wostream& stream) {
+			for (size_t i = 0; i < this->capacity; i++) {
+				if (this->slots[i].key == this->empty_key) continue;
+
+				stream << this->slots[i].key << L": " << this->slots[i].value << L"\n";
+			}
+		}
+	};
+
+	/// <summary>
+	/// An open addressing set of keys using linear probing, storing only the keys and one byte per slot marking it used.
+	/// remove() shifts the following keys back instead of leaving tombstones.
+	/// </summary>
+	/// <typeparam name="KT">The type of the keys.</typeparam>
+	template <typename KT>
+	class HashSet
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+	private:
+		//the set grows once more than this fraction of the slots are used
+		static constexpr double MAX_LOAD_FACTOR = 0.75;
+
+		//1 for every used slot
+		unsigned char* used;
+
+		//keys, capacity is always a power of two
+		KT* keys;
+		size_t capacity;
+
+		//number of keys stored
+		unsigned long count = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		//if the set was created for int_hash_function, whose mix is applied to the key directly
+		bool mix_key = false;
+
+		/// <summary>
+		/// Get the ideal slot of a key.
+		/// </summary>
+		size_t home_of(const KT& key) const {
+			//going through int_hash_function would mix twice and cut the key to an unsigned long
+			if constexpr (std::is_integral_v<KT>) {
+				if (this->mix_key) return (size_t)mix_hash((unsigned long long)key) & (this->capacity - 1);
+			}
+
+			return (size_t)mix_hash(this->hash_function(key, ULONG_MAX)) & (this->capacity - 1);
+		}
+
+		/// <summary>
+		/// Find the slot index of a key.
+		/// </summary>
+		/// <returns>The index of the slot, capacity if the key is not in the set.</returns>
+		size_t find_index(const KT& key) const {
+			size_t mask = this->capacity - 1;
+
+			for (size_t index = this->home_of(key); this->used[index]; index = (index + 1) & mask) {
+				if (this->keys[index] == key) return index;
+			}
+
+			return this->capacity;
+		}
+
+		/// <summary>
+		/// Move every key into a slot array of a new size.
+		/// </summary>
+		void resize(size_t new_capacity) {
+			unsigned char* old_used = this->used;
+			KT* old_keys = this->keys;
+			size_t old_capacity = this->capacity;
+
+			this->used = new unsigned char[new_capacity]();
+			this->keys = new KT[new_capacity];
+			this->capacity = new_capacity;
+
+			size_t mask = this->capacity - 1;
+
+			for (size_t i = 0; i < old_capacity; i++) {
+				if (!old_used[i]) continue;
+
+				size_t index = this->home_of(old_keys[i]);
+				while (this->used[index]) index = (index + 1) & mask;
+
+				this->used[index] = 1;
+				this->keys[index] = std::move(old_keys[i]);
+			}
+
+			delete[] old_used;
+			delete[] old_keys;
+		}
+
+	public:
+		/// <summary>
+		/// Create a HashSet.
+		/// </summary>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		/// <param name="size">Expected number of keys.</param>
+		HashSet(HASH_FUNC hashing_function, unsigned long size = 128) {
+			this->hash_function = hashing_function;
+
+			//round the capacity up to a power of two large enough for size keys
+			this->capacity = 8;
+			while (this->capacity * MAX_LOAD_FACTOR < size) {
+				this->capacity *= 2;
+			}
+
+			used = new unsigned char[this->capacity]();
+			keys = new KT[this->capacity];
+		}
+
+		/// <summary>
+		/// Create a HashSet of integers hashed with int_hash_function.
+		/// </summary>
+		/// <param name="size">Expected number of keys.</param>
+		HashSet(unsigned long size = 128) requires std::is_integral_v<KT> : HashSet(int_hash_function<KT>, size) {
+			this->mix_key = true;
+		}
+
+		HashSet(const HashSet&) = delete;
+		HashSet& operator= (const HashSet&) = delete;
+
+		~HashSet() {
+			delete[] this->used;
+			delete[] this->keys;
+		}
+
+		/// <summary>
+		/// Add a key to the set.
+		/// </summary>
+		/// <returns>False if the key was already in the set.</returns>
+		bool insert(const KT& key) {
+			if (this->find_index(key) != this->capacity) return false;
+
+			if (this->count + 1 > this->capacity * MAX_LOAD_FACTOR) {
+				this->resize(this->capacity * 2);
+			}
+
+			size_t mask = this->capacity - 1;
+
+			size_t index = this->home_of(key);
+			while (this->used[index]) index = (index + 1) & mask;
+
+			this->used[index] = 1;
+			this->keys[index] = key;
+
+			this->count++;
+			return true;
+		}
+
+		/// <summary>
+		/// Check if a key is in the set.
+		/// </summary>
+		bool contains(const KT& key) const {
+			return this->find_index(key) != this->capacity;
+		}
+
+		/// <summary>
+		/// Remove a key from the set, shifting the following keys back.
+		/// </summary>
+		/// <returns>If the key was found and removed.</returns>
+		bool remove(const KT& key) {
+			size_t index = this->find_index(key);
+
+			if (index == this->capacity) return false;
+
+			size_t mask = this->capacity - 1;
+
+			//move back every following key whose home is not between the freed slot and its current slot
+			for (size_t next = (index + 1) & mask; this->used[next]; next = (next + 1) & mask) {
+				size_t home = this->home_of(this->keys[next]);
+
+				bool stays = index <= next ? (home > index && home <= next) : (home > index || home <= next);
+				if (stays) continue;
+
+				this->keys[index] = std::move(this->keys[next]);
+				index = next;
+			}
+
+			//reset the freed slot so the removed key releases its memory
+			this->used[index] = 0;
+			this->keys[index] = KT();
+
+			this->count--;
+			return true;
+		}
+
+		/// <summary>
+		/// Return the number of keys in the set.
+		/// </summary>
+		unsigned long size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Return the fraction of slots which are in use.
+		/// </summary>
+		double load_factor() const {
+			return (double)this->count / (double)this->capacity;
+		}
+
+		/// <summary>
+		/// Return the number of bytes used by the slot arrays, not counting memory owned by the keys.
+		/// </summary>
+		size_t memory_usage() const {
+			return this->capacity * (sizeof(KT) + 1);
+		}
+	};
+};
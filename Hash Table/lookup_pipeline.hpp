@@ -0,0 +1,291 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <vector>
+#include "hash_table.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
+
+namespace hash_table {
+	//hint to the cpu that an address will be read soon
+	inline void prefetch(const void* address) {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+		_mm_prefetch((const char*)address, _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(address);
+#else
+		(void)address;
+#endif
+	}
+
+	/// <summary>
+	/// A per thread free list of coroutine frames, lookup frames all have the same size so they are recycled
+	/// instead of going back to the heap after every lookup.
+	/// </summary>
+	class FramePool {
+	private:
+		//size of the frames in the free list
+		size_t frame_size = 0;
+
+		//frames ready to be reused
+		std::vector<void*> free_frames;
+
+	public:
+		FramePool() {}
+
+		FramePool(const FramePool&) = delete;
+		FramePool& operator= (const FramePool&) = delete;
+
+		~FramePool() {
+			for (auto frame : this->free_frames) {
+				::operator delete(frame);
+			}
+		}
+
+		/// <summary>
+		/// Return the pool of the calling thread.
+		/// </summary>
+		static FramePool& local() {
+			thread_local FramePool pool;
+			return pool;
+		}
+
+		/// <summary>
+		/// Allocate a frame, reusing a released one of the same size if possible.
+		/// </summary>
+		void* allocate(size_t size) {
+			if (size == this->frame_size && !this->free_frames.empty()) {
+				void* frame = this->free_frames.back();
+				this->free_frames.pop_back();
+				return frame;
+			}
+
+			return ::operator new(size);
+		}
+
+		/// <summary>
+		/// Release a frame into the free list.
+		/// </summary>
+		void release(void* frame, size_t size) {
+			//the pool keeps frames of the first size it is given
+			if (this->frame_size == 0) this->frame_size = size;
+
+			if (size == this->frame_size) {
+				this->free_frames.push_back(frame);
+			}
+			else {
+				::operator delete(frame);
+			}
+		}
+	};
+
+	/// <summary>
+	/// A suspended lookup, resumed step by step by a LookupPipeline or run to completion with get().
+	/// </summary>
+	/// <typeparam name="VT">The type of the value being looked up.</typeparam>
+	template <typename VT>
+	class LookupTask
+	{
+	public:
+		struct promise_type {
+			VT* result = nullptr;
+			std::exception_ptr exception;
+
+			LookupTask get_return_object() {
+				return LookupTask(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+
+			void return_value(VT* value) {
+				this->result = value;
+			}
+
+			void unhandled_exception() {
+				this->exception = std::current_exception();
+			}
+
+			static void* operator new(size_t size) {
+				return FramePool::local().allocate(size);
+			}
+
+			static void operator delete(void* frame, size_t size) {
+				FramePool::local().release(frame, size);
+			}
+		};
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+
+	public:
+		LookupTask() {}
+
+		explicit LookupTask(std::coroutine_handle<promise_type> handle) {
+			this->handle = handle;
+		}
+
+		LookupTask(const LookupTask&) = delete;
+		LookupTask& operator= (const LookupTask&) = delete;
+
+		LookupTask(LookupTask&& other) noexcept {
+			this->handle = other.handle;
+			other.handle = nullptr;
+		}
+
+		LookupTask& operator= (LookupTask&& other) noexcept {
+			std::swap(this->handle, other.handle);
+			return *this;
+		}
+
+		~LookupTask() {
+			if (this->handle) this->handle.destroy();
+		}
+
+		/// <summary>
+		/// Check if the lookup has finished.
+		/// </summary>
+		bool done() const {
+			return !this->handle || this->handle.done();
+		}
+
+		/// <summary>
+		/// Run the lookup until its next memory access.
+		/// </summary>
+		void resume() {
+			this->handle.resume();
+		}
+
+		/// <summary>
+		/// Return the result of a finished lookup.
+		/// </summary>
+		/// <returns>Pointer to the value, nullptr if the key is not in the table.</returns>
+		VT* result() const {
+			if (this->handle.promise().exception) std::rethrow_exception(this->handle.promise().exception);
+
+			return this->handle.promise().result;
+		}
+
+		/// <summary>
+		/// Run the lookup to completion and return its result.
+		/// </summary>
+		VT* get() {
+			while (!this->done()) {
+				this->resume();
+			}
+
+			return this->result();
+		}
+	};
+
+	/// <summary>
+	/// Runs many independent lookups against a HashTable at once.
+	/// Each lookup prefetches the next bucket or node it needs and then yields to another lookup,
+	/// so the memory latency of one chain walk is hidden behind the work of the others.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	/// <typeparam name="Allocator">Allocator of the table.</typeparam>
+	template <typename KT, typename VT, typename Allocator>
+	class LookupPipeline
+	{
+	public:
+		typedef typename HashTable<KT, VT, Allocator>::HashEntry HashEntry;
+		typedef typename HashEntry::HashNode HashNode;
+
+	private:
+		//table being searched
+		HashTable<KT, VT, Allocator>& table;
+
+		//number of lookups in flight at once
+		size_t width;
+
+	public:
+		/// <summary>
+		/// Create a LookupPipeline for a table.
+		/// </summary>
+		/// <param name="table">The table to be searched.</param>
+		/// <param name="width">Number of lookups interleaved at once.</param>
+		LookupPipeline(HashTable<KT, VT, Allocator>& table, size_t width = 16) : table(table) {
+			this->width = width == 0 ? 1 : width;
+		}
+
+		/// <summary>
+		/// Start a lookup which suspends before every bucket and node it reads.
+		/// The frame only holds a reference to the key, so a long key is not copied into it and must outlive the lookup.
+		/// A HASH_FUNC takes its key by value, so hashing still makes one short lived copy of a key longer than the small string buffer.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>The suspended lookup.</returns>
+		LookupTask<VT> async_get(const KT& key) {
+			HashEntry** slot = &this->table.table[this->table.hash_function(key, this->table.table_size)];
+
+			prefetch(slot);
+			co_await std::suspend_always{};
+
+			HashEntry* entry = *slot;
+			if (entry == nullptr) co_return nullptr;
+
+			prefetch(entry);
+			co_await std::suspend_always{};
+
+			for (HashNode* node = entry->head; node != nullptr; node = node->back) {
+				prefetch(node);
+				co_await std::suspend_always{};
+
+				if (node->key == key) co_return &node->value;
+			}
+
+			co_return nullptr;
+		}
+
+		/// <summary>
+		/// Look up many keys, keeping up to width lookups in flight.
+		/// </summary>
+		/// <param name="keys">The keys to be searched for.</param>
+		/// <returns>Pointers to the values in the same order as the keys, nullptr for missing keys.</returns>
+		std::vector<VT*> multi_get(const std::vector<KT>& keys) {
+			std::vector<VT*> results(keys.size(), nullptr);
+
+			std::vector<LookupTask<VT>> tasks(this->width);
+			std::vector<size_t> task_keys(this->width);
+
+			size_t next_key = 0;
+			size_t running = 0;
+
+			//start the first batch of lookups
+			for (size_t i = 0; i < this->width && next_key < keys.size(); i++) {
+				tasks[i] = this->async_get(keys[next_key]);
+				task_keys[i] = next_key++;
+				running++;
+			}
+
+			//round robin over the lookups, replacing each finished lookup with the next key
+			while (running > 0) {
+				for (size_t i = 0; i < this->width; i++) {
+					if (tasks[i].done()) continue;
+
+					tasks[i].resume();
+
+					if (tasks[i].done()) {
+						results[task_keys[i]] = tasks[i].result();
+
+						if (next_key < keys.size()) {
+							tasks[i] = this->async_get(keys[next_key]);
+							task_keys[i] = next_key++;
+						}
+						else {
+							tasks[i] = LookupTask<VT>();
+							running--;
+						}
+					}
+				}
+			}
+
+			return results;
+		}
+	};
+};
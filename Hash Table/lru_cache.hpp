@@ -0,0 +1,307 @@
+#pragma once
+
+#include <functional>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// A capacity bounded Hash Table which evicts the least recently used entry when full.
+	/// Each node is linked into both its bucket chain and the recency list, so no second index is needed.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class LruCache
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+		typedef std::function<void(const KT&, const VT&)> EVICT_FUNC;
+
+		/// <summary>
+		/// Object representing a cached Key/Value pair.
+		/// </summary>
+		struct CacheNode {
+			/// <summary>
+			/// Reference to the next node in the same bucket.
+			/// </summary>
+			CacheNode* next = nullptr;
+
+			/// <summary>
+			/// Reference to the more recently used node.
+			/// </summary>
+			CacheNode* front = nullptr;
+
+			/// <summary>
+			/// Reference to the less recently used node.
+			/// </summary>
+			CacheNode* back = nullptr;
+
+			/// <summary>
+			/// Key of the node.
+			/// </summary>
+			KT key;
+
+			/// <summary>
+			/// Value stored in the node.
+			/// </summary>
+			VT value;
+
+			CacheNode(KT key, VT value) {
+				this->key = key;
+				this->value = value;
+			}
+		};
+
+	private:
+		//bucket chains
+		CacheNode** table;
+
+		//table values
+		unsigned long table_size;
+		unsigned long max_size;
+		unsigned long count = 0;
+
+		//most and least recently used nodes
+		CacheNode* head = nullptr;
+		CacheNode* tail = nullptr;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		//function called with each evicted entry
+		EVICT_FUNC on_evict;
+
+		//cache statistics
+		unsigned long long hit_count = 0;
+		unsigned long long miss_count = 0;
+		unsigned long long eviction_count = 0;
+
+		/// <summary>
+		/// Find the link pointing at the node with the specified key.
+		/// </summary>
+		/// <returns>Pointer to the link, the link holds nullptr if no matching node was found.</returns>
+		CacheNode** find_link(const KT& key) {
+			CacheNode** link = &this->table[this->hash_function(key, this->table_size)];
+
+			while (*link != nullptr && !((*link)->key == key)) {
+				link = &(*link)->next;
+			}
+
+			return link;
+		}
+
+		/// <summary>
+		/// Remove a node from the recency list.
+		/// </summary>
+		void unlink(CacheNode* node) {
+			if (node->front != nullptr) node->front->back = node->back;
+			else this->head = node->back;
+
+			if (node->back != nullptr) node->back->front = node->front;
+			else this->tail = node->front;
+
+			node->front = nullptr;
+			node->back = nullptr;
+		}
+
+		/// <summary>
+		/// Add a node to the front of the recency list.
+		/// </summary>
+		void link_front(CacheNode* node) {
+			node->back = this->head;
+
+			if (this->head != nullptr) this->head->front = node;
+			else this->tail = node;
+
+			this->head = node;
+		}
+
+		/// <summary>
+		/// Detach the least recently used node from the cache, the caller takes ownership of it.
+		/// </summary>
+		CacheNode* evict() {
+			CacheNode* node = this->tail;
+
+			//remove the node from its bucket chain
+			CacheNode** link = this->find_link(node->key);
+			*link = node->next;
+			node->next = nullptr;
+
+			this->unlink(node);
+			this->count--;
+			this->eviction_count++;
+
+			if (this->on_evict) this->on_evict(node->key, node->value);
+
+			return node;
+		}
+
+	public:
+		/// <summary>
+		/// Create a cache holding at most capacity entries.
+		/// </summary>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		/// <param name="capacity">Maximum number of entries.</param>
+		/// <param name="eviction_callback">Called with each entry evicted to make room.</param>
+		LruCache(HASH_FUNC hashing_function, unsigned long capacity = 128, EVICT_FUNC eviction_callback = nullptr) {
+			this->hash_function = hashing_function;
+			this->max_size = capacity == 0 ? 1 : capacity;
+			this->table_size = this->max_size;
+			this->on_evict = eviction_callback;
+
+			table = new CacheNode*[this->table_size]();
+		}
+
+		LruCache(const LruCache&) = delete;
+		LruCache& operator= (const LruCache&) = delete;
+
+		~LruCache() {
+			clear();
+			delete[] this->table;
+		}
+
+		/// <summary>
+		/// Get a pointer to a cached value, marking it as the most recently used entry.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>Pointer to the value, nullptr on a miss.</returns>
+		VT* get(KT key) {
+			CacheNode* node = *this->find_link(key);
+
+			if (node == nullptr) {
+				this->miss_count++;
+				return nullptr;
+			}
+
+			this->hit_count++;
+
+			//promote the node to most recently used
+			if (node != this->head) {
+				this->unlink(node);
+				this->link_front(node);
+			}
+
+			return &node->value;
+		}
+
+		/// <summary>
+		/// Insert or update a value, evicting the least recently used entry if the cache is full.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		void insert(const KT key, VT value) {
+			CacheNode** link = this->find_link(key);
+
+			//update an existing entry in place
+			if (*link != nullptr) {
+				CacheNode* node = *link;
+				node->value = value;
+
+				if (node != this->head) {
+					this->unlink(node);
+					this->link_front(node);
+				}
+
+				return;
+			}
+
+			CacheNode* node;
+
+			//reuse the evicted node instead of allocating a new one
+			if (this->count == this->max_size) {
+				node = this->evict();
+				node->key = key;
+				node->value = value;
+
+				//the chain may have changed while evicting so find the link again
+				link = this->find_link(key);
+			}
+			else {
+				node = new CacheNode(key, value);
+			}
+
+			*link = node;
+			this->link_front(node);
+			this->count++;
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the cache.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			CacheNode** link = this->find_link(key);
+			CacheNode* node = *link;
+
+			if (node == nullptr) return false;
+
+			*link = node->next;
+			this->unlink(node);
+			this->count--;
+
+			delete node;
+			return true;
+		}
+
+		/// <summary>
+		/// Remove every entry without calling the eviction callback.
+		/// </summary>
+		void clear() {
+			while (this->head != nullptr) {
+				CacheNode* node = this->head;
+				this->head = node->back;
+				delete node;
+			}
+
+			this->tail = nullptr;
+			this->count = 0;
+
+			for (unsigned long i = 0; i < this->table_size; i++) {
+				this->table[i] = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Set the function called with each evicted entry.
+		/// </summary>
+		void set_eviction_callback(EVICT_FUNC eviction_callback) {
+			this->on_evict = eviction_callback;
+		}
+
+		/// <summary>
+		/// Return the number of entries in the cache.
+		/// </summary>
+		unsigned long size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Return the maximum number of entries in the cache.
+		/// </summary>
+		unsigned long capacity() const {
+			return this->max_size;
+		}
+
+		/// <summary>
+		/// Return the number of get() calls which found their key.
+		/// </summary>
+		unsigned long long hits() const {
+			return this->hit_count;
+		}
+
+		/// <summary>
+		/// Return the number of get() calls which did not find their key.
+		/// </summary>
+		unsigned long long misses() const {
+			return this->miss_count;
+		}
+
+		/// <summary>
+		/// Return the number of entries evicted to make room for new ones.
+		/// </summary>
+		unsigned long long evictions() const {
+			return this->eviction_count;
+		}
+	};
+};
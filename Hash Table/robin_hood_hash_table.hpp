@@ -0,0 +1,310 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <climits>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	/// <summary>
+	/// An open addressing Hash Table using Robin Hood linear probing.
+	/// Every slot records how far it is from its ideal position, which keeps probe lengths even,
+	/// lets unsuccessful lookups stop early, and lets remove() shift entries back instead of leaving tombstones.
+	/// An entry whose probe distance would not fit in a byte, which only happens when hundreds of keys share a hash,
+	/// is kept in an overflow list instead of growing the table.
+	/// </summary>
+	/// <typeparam name="KT">The type of the entry key.</typeparam>
+	/// <typeparam name="VT">The type of the entry value.</typeparam>
+	template <typename KT, typename VT>
+	class RobinHoodHashTable
+	{
+	public:
+		typedef unsigned long(*HASH_FUNC)(KT, unsigned long);
+
+		/// <summary>
+		/// A Key/Value pair stored in the slot array.
+		/// </summary>
+		struct Slot {
+			KT key;
+			VT value;
+		};
+
+	private:
+		//the table grows once more than this fraction of the slots are used
+		static constexpr double MAX_LOAD_FACTOR = 0.9;
+
+		//largest probe distance which can be stored, entries past it go to the overflow list
+		static constexpr unsigned char MAX_DISTANCE = UCHAR_MAX;
+
+		//probe distance plus one of every slot, 0 marks an empty slot
+		unsigned char* distances;
+
+		//Key/Value pairs, capacity is always a power of two
+		Slot* slots;
+		size_t capacity;
+
+		//entries which could not be placed within MAX_DISTANCE of their home
+		std::vector<Slot> overflow;
+
+		//number of Key/Value pairs stored, including the overflow list
+		unsigned long count = 0;
+
+		//function used to hash keys
+		HASH_FUNC hash_function;
+
+		/// <summary>
+		/// Get the ideal slot of a key.
+		/// </summary>
+		size_t home_of(const KT& key) const {
+			return (size_t)mix_hash(this->hash_function(key, ULONG_MAX)) & (this->capacity - 1);
+		}
+
+		/// <summary>
+		/// Find the slot index of a key.
+		/// </summary>
+		/// <returns>The index of the slot, capacity if the key is not in the table.</returns>
+		size_t find_index(const KT& key) const {
+			size_t mask = this->capacity - 1;
+			size_t index = this->home_of(key);
+
+			for (unsigned int distance = 1; distance <= MAX_DISTANCE; distance++) {
+				//a slot closer to its home than we are to ours means the key would have been placed before it
+				if (this->distances[index] < distance) break;
+
+				if (this->distances[index] == distance && this->slots[index].key == key) {
+					return index;
+				}
+
+				index = (index + 1) & mask;
+			}
+
+			return this->capacity;
+		}
+
+		/// <summary>
+		/// Find the overflow index of a key.
+		/// </summary>
+		/// <returns>The index in the overflow list, its size if the key is not in it.</returns>
+		size_t find_overflow(const KT& key) const {
+			size_t index = 0;
+
+			while (index < this->overflow.size() && !(this->overflow[index].key == key)) {
+				index++;
+			}
+
+			return index;
+		}
+
+		/// <summary>
+		/// Place a key which is not in the table, taking slots from entries closer to their home.
+		/// </summary>
+		/// <returns>If the entry was placed, false if a probe distance would exceed MAX_DISTANCE.</returns>
+		bool place(KT& key, VT& value) {
+			size_t mask = this->capacity - 1;
+			size_t index = this->home_of(key);
+			unsigned int distance = 1;
+
+			while (true) {
+				if (this->distances[index] == 0) {
+					this->distances[index] = (unsigned char)distance;
+					this->slots[index].key = std::move(key);
+					this->slots[index].value = std::move(value);
+					return true;
+				}
+
+				//take the slot from a richer entry and keep placing the entry that was displaced
+				if (this->distances[index] < distance) {
+					unsigned char displaced = this->distances[index];
+					this->distances[index] = (unsigned char)distance;
+					distance = displaced;
+
+					std::swap(key, this->slots[index].key);
+					std::swap(value, this->slots[index].value);
+				}
+
+				index = (index + 1) & mask;
+				distance++;
+
+				if (distance > MAX_DISTANCE) return false;
+			}
+		}
+
+		/// <summary>
+		/// Move every entry into a slot array of a new size.
+		/// </summary>
+		void resize(size_t new_capacity) {
+			unsigned char* old_distances = this->distances;
+			Slot* old_slots = this->slots;
+			size_t old_capacity = this->capacity;
+			std::vector<Slot> old_overflow = std::move(this->overflow);
+
+			this->capacity = new_capacity;
+			this->distances = new unsigned char[this->capacity]();
+			this->slots = new Slot[this->capacity];
+			this->overflow.clear();
+
+			for (size_t i = 0; i < old_capacity; i++) {
+				if (old_distances[i] != 0) {
+					this->reinsert(old_slots[i].key, old_slots[i].value);
+				}
+			}
+
+			for (auto& item : old_overflow) {
+				this->reinsert(item.key, item.value);
+			}
+
+			delete[] old_distances;
+			delete[] old_slots;
+		}
+
+		/// <summary>
+		/// Place an entry, moving whichever entry is left without a slot to the overflow list.
+		/// </summary>
+		void reinsert(KT& key, VT& value) {
+			if (!this->place(key, value)) {
+				//key and value now hold the entry that could not be placed
+				this->overflow.push_back(Slot{ std::move(key), std::move(value) });
+			}
+		}
+
+	public:
+		/// <summary>
+		/// Create a RobinHoodHashTable.
+		/// </summary>
+		/// <param name="hashing_function">The function used to hash keys.</param>
+		/// <param name="size">Expected number of entries.</param>
+		RobinHoodHashTable(HASH_FUNC hashing_function, unsigned long size = 128) {
+			this->hash_function = hashing_function;
+
+			//round the capacity up to a power of two large enough for size entries
+			this->capacity = 8;
+			while (this->capacity * MAX_LOAD_FACTOR < size) {
+				this->capacity *= 2;
+			}
+
+			distances = new unsigned char[this->capacity]();
+			slots = new Slot[this->capacity];
+		}
+
+		RobinHoodHashTable(const RobinHoodHashTable&) = delete;
+		RobinHoodHashTable& operator= (const RobinHoodHashTable&) = delete;
+
+		~RobinHoodHashTable() {
+			delete[] this->distances;
+			delete[] this->slots;
+		}
+
+		/// <summary>
+		/// Insert a value, replacing the value of an existing key.
+		/// </summary>
+		/// <param name="key">The key of the entry.</param>
+		/// <param name="value">The value of the entry.</param>
+		void insert(const KT key, VT value) {
+			size_t index = this->find_index(key);
+
+			if (index != this->capacity) {
+				this->slots[index].value = value;
+				return;
+			}
+
+			size_t overflow_index = this->find_overflow(key);
+			if (overflow_index != this->overflow.size()) {
+				this->overflow[overflow_index].value = value;
+				return;
+			}
+
+			if (this->count + 1 > this->capacity * MAX_LOAD_FACTOR) {
+				this->resize(this->capacity * 2);
+			}
+
+			KT new_key = key;
+			VT new_value = value;
+			this->reinsert(new_key, new_value);
+
+			this->count++;
+		}
+
+		/// <summary>
+		/// Get a pointer to the value stored by a given key.
+		/// </summary>
+		/// <param name="key">The key representing the value.</param>
+		/// <returns>Pointer to the value, nullptr if the key is not in the table.</returns>
+		VT* get(KT key) {
+			size_t index = this->find_index(key);
+			if (index != this->capacity) return &this->slots[index].value;
+
+			//the overflow list is empty unless hundreds of keys share a hash
+			index = this->find_overflow(key);
+
+			return index == this->overflow.size() ? nullptr : &this->overflow[index].value;
+		}
+
+		/// <summary>
+		/// Remove a value with the specified key from the table, shifting the following entries back.
+		/// </summary>
+		/// <param name="key">The key to be searched for.</param>
+		/// <returns>If the value was found and removed.</returns>
+		bool remove(KT key) {
+			size_t index = this->find_index(key);
+
+			if (index == this->capacity) {
+				size_t overflow_index = this->find_overflow(key);
+				if (overflow_index == this->overflow.size()) return false;
+
+				this->overflow.erase(this->overflow.begin() + overflow_index);
+
+				this->count--;
+				return true;
+			}
+
+			size_t mask = this->capacity - 1;
+			size_t next = (index + 1) & mask;
+
+			//shift back every following entry which is not in its home slot
+			while (this->distances[next] > 1) {
+				this->distances[index] = this->distances[next] - 1;
+				this->slots[index].key = std::move(this->slots[next].key);
+				this->slots[index].value = std::move(this->slots[next].value);
+
+				index = next;
+				next = (next + 1) & mask;
+			}
+
+			//reset the freed slot so the removed key and value release their memory
+			this->distances[index] = 0;
+			this->slots[index].key = KT();
+			this->slots[index].value = VT();
+
+			this->count--;
+			return true;
+		}
+
+		/// <summary>
+		/// Return the total number of Key/Value pairs stored in the table.
+		/// </summary>
+		/// <returns>The total number of records.</returns>
+		unsigned long size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Return the fraction of slots which are in use.
+		/// </summary>
+		double load_factor() const {
+			return (double)this->count / (double)this->capacity;
+		}
+
+		/// <summary>
+		/// Return the longest probe distance currently in the table.
+		/// </summary>
+		unsigned int max_probe_distance() const {
+			unsigned int longest = 0;
+
+			for (size_t i = 0; i < this->capacity; i++) {
+				if (this->distances[i] > longest) longest = this->distances[i];
+			}
+
+			return longest == 0 ? 0 : longest - 1;
+		}
+	};
+};
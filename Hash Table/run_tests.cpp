@@ -0,0 +1,6 @@
+#include "hash_table_test.hpp"
+
+//runs the functionality test without the interactive menu, the exit code reports the result
+int main() {
+	return hash_table_testing::test_functionality() ? 0 : 1;
+}
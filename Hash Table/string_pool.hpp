@@ -0,0 +1,267 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include "hash_table.hpp"
+
+namespace hash_table {
+	class StringPool;
+
+	/// <summary>
+	/// A handle to a string stored once in a StringPool.
+	/// Two handles from the same pool are equal exactly when their text is equal, so comparing them is a pointer compare.
+	/// A default constructed handle refers to no string and is only equal to other empty handles.
+	/// </summary>
+	class InternedString
+	{
+		friend StringPool;
+
+	public:
+		/// <summary>
+		/// Header stored in the pool in front of the text of every string.
+		/// </summary>
+		struct Record {
+			unsigned long long hash;
+			size_t length;
+
+			/// <summary>
+			/// Return the text stored after the header.
+			/// </summary>
+			const wchar_t* text() const {
+				return (const wchar_t*)(this + 1);
+			}
+		};
+
+	private:
+		//string in the pool, nullptr for an empty handle
+		const Record* record = nullptr;
+
+		InternedString(const Record* record) {
+			this->record = record;
+		}
+
+	public:
+		InternedString() {}
+
+		/// <summary>
+		/// Return the number of characters in the string.
+		/// </summary>
+		size_t length() const {
+			return this->record == nullptr ? 0 : this->record->length;
+		}
+
+		/// <summary>
+		/// Return the null terminated text of the string.
+		/// </summary>
+		const wchar_t* c_str() const {
+			return this->record == nullptr ? L"" : this->record->text();
+		}
+
+		/// <summary>
+		/// Return a copy of the text as a wstring.
+		/// </summary>
+		std::wstring str() const {
+			return std::wstring(this->c_str(), this->length());
+		}
+
+		/// <summary>
+		/// Return the hash of the text, computed once when it was interned.
+		/// </summary>
+		unsigned long long hash() const {
+			return this->record == nullptr ? 0 : this->record->hash;
+		}
+
+		/// <summary>
+		/// Check if the handle refers to no string.
+		/// </summary>
+		bool empty() const {
+			return this->record == nullptr;
+		}
+
+		bool operator== (const InternedString& other) const {
+			return this->record == other.record;
+		}
+
+		bool operator!= (const InternedString& other) const {
+			return this->record != other.record;
+		}
+
+		friend std::wostream& operator<< (std::wostream& stream, const InternedString& text) {
+			return stream.write(text.c_str(), text.length());
+		}
+	};
+
+	/// <summary>
+	/// Hashing function for tables keyed by InternedString, it reuses the hash stored in the pool.
+	/// </summary>
+	inline unsigned long interned_hash_function(InternedString key, unsigned long size) {
+		return (unsigned long)(key.hash() % size);
+	}
+
+	/// <summary>
+	/// An append only arena which stores each distinct string once and hands out InternedString handles to it.
+	/// Strings are never freed until the pool is destroyed, so the pool must outlive every handle and table using it.
+	/// </summary>
+	class StringPool
+	{
+	public:
+		typedef InternedString::Record Record;
+
+		/// <summary>
+		/// Size in bytes of each arena chunk, longer strings get a chunk of their own.
+		/// </summary>
+		static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+	private:
+		//arena chunks holding records and their text
+		std::vector<char*> chunks;
+
+		//bytes used in the last chunk and its size
+		size_t chunk_used = 0;
+		size_t chunk_size = 0;
+
+		//total bytes of every chunk
+		size_t arena_bytes = 0;
+
+		//open addressing index of every record, its size is a power of two and is kept at most half full
+		std::vector<const Record*> index;
+		size_t count = 0;
+
+		/// <summary>
+		/// Hash the text of a string.
+		/// </summary>
+		static unsigned long long hash_text(const wchar_t* text, size_t length) {
+			//fnv-1a
+			unsigned long long hash = 0xCBF29CE484222325ull;
+
+			for (size_t i = 0; i < length; i++) {
+				hash ^= (unsigned long long)text[i];
+				hash *= 0x100000001B3ull;
+			}
+
+			return mix_hash(hash);
+		}
+
+		/// <summary>
+		/// Find the index slot holding a string, or the empty slot where it belongs.
+		/// </summary>
+		size_t find_slot(const wchar_t* text, size_t length, unsigned long long hash) const {
+			size_t mask = this->index.size() - 1;
+
+			for (size_t slot = (size_t)hash & mask;; slot = (slot + 1) & mask) {
+				const Record* record = this->index[slot];
+
+				if (record == nullptr) return slot;
+
+				if (record->hash == hash && record->length == length && std::wmemcmp(record->text(), text, length) == 0) {
+					return slot;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Double the size of the index.
+		/// </summary>
+		void grow_index() {
+			std::vector<const Record*> old_index = std::move(this->index);
+			this->index.assign(old_index.size() * 2, nullptr);
+
+			size_t mask = this->index.size() - 1;
+
+			for (const Record* record : old_index) {
+				if (record == nullptr) continue;
+
+				size_t slot = (size_t)record->hash & mask;
+				while (this->index[slot] != nullptr) slot = (slot + 1) & mask;
+
+				this->index[slot] = record;
+			}
+		}
+
+		/// <summary>
+		/// Copy a string into the arena.
+		/// </summary>
+		const Record* append(const wchar_t* text, size_t length, unsigned long long hash) {
+			//keep every record aligned for its header
+			size_t bytes = sizeof(Record) + (length + 1) * sizeof(wchar_t);
+			bytes = (bytes + alignof(Record) - 1) / alignof(Record) * alignof(Record);
+
+			if (this->chunks.empty() || this->chunk_used + bytes > this->chunk_size) {
+				this->chunk_size = bytes > CHUNK_SIZE ? bytes : CHUNK_SIZE;
+				this->chunk_used = 0;
+				this->chunks.push_back(new char[this->chunk_size]);
+				this->arena_bytes += this->chunk_size;
+			}
+
+			Record* record = (Record*)(this->chunks.back() + this->chunk_used);
+			this->chunk_used += bytes;
+
+			record->hash = hash;
+			record->length = length;
+
+			wchar_t* copy = (wchar_t*)(record + 1);
+			std::wmemcpy(copy, text, length);
+			copy[length] = L'\0';
+
+			return record;
+		}
+
+	public:
+		StringPool() {
+			this->index.assign(64, nullptr);
+		}
+
+		StringPool(const StringPool&) = delete;
+		StringPool& operator= (const StringPool&) = delete;
+
+		~StringPool() {
+			for (char* chunk : this->chunks) {
+				delete[] chunk;
+			}
+		}
+
+		/// <summary>
+		/// Return the handle of a string, copying it into the pool the first time it is seen.
+		/// </summary>
+		InternedString intern(const std::wstring& text) {
+			unsigned long long hash = hash_text(text.data(), text.length());
+			size_t slot = this->find_slot(text.data(), text.length(), hash);
+
+			if (this->index[slot] != nullptr) return InternedString(this->index[slot]);
+
+			const Record* record = this->append(text.data(), text.length(), hash);
+			this->index[slot] = record;
+			this->count++;
+
+			if (this->count * 2 > this->index.size()) this->grow_index();
+
+			return InternedString(record);
+		}
+
+		/// <summary>
+		/// Return the handle of a string without adding it, an empty handle is returned if it was never interned.
+		/// Use this for lookups so that missing keys don't grow the pool.
+		/// </summary>
+		InternedString find(const std::wstring& text) const {
+			size_t slot = this->find_slot(text.data(), text.length(), hash_text(text.data(), text.length()));
+
+			return InternedString(this->index[slot]);
+		}
+
+		/// <summary>
+		/// Return the number of distinct strings in the pool.
+		/// </summary>
+		size_t size() const {
+			return this->count;
+		}
+
+		/// <summary>
+		/// Return the number of bytes used by the arena and its index.
+		/// </summary>
+		size_t memory_usage() const {
+			return this->arena_bytes + this->index.size() * sizeof(const Record*);
+		}
+	};
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hash_table {
+	/// <summary>
+	/// A pool of threads which runs a numbered set of chunks. Each worker starts with an even share of the chunks
+	/// and once it runs out steals half of the remaining chunks of another worker, so uneven chunks still balance.
+	/// The calling thread works as worker 0. Scheduling allocates nothing, a chunk must not start another run on the same pool.
+	/// If a chunk throws, the workers stop taking chunks and run() rethrows the first exception once all of them have stopped.
+	/// </summary>
+	class WorkStealingPool
+	{
+	public:
+		typedef void(*TASK)(void* context, unsigned long chunk, unsigned int worker);
+
+	private:
+		/// <summary>
+		/// Range of chunks owned by a worker, the next chunk in the low 32 bits and the end in the high 32 bits.
+		/// Kept on its own cache line since it is updated by its owner and by thieves.
+		/// </summary>
+		struct alignas(64) Queue {
+			std::atomic<uint64_t> range{ 0 };
+		};
+
+		//threads besides the caller
+		std::vector<std::thread> threads;
+
+		//one queue per worker
+		std::unique_ptr<Queue[]> queues;
+		unsigned int workers;
+
+		//current job, guarded by mutex
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		uint64_t job = 0;
+		unsigned int active = 0;
+		bool stopping = false;
+		TASK task = nullptr;
+		void* context = nullptr;
+
+		//first exception thrown by a chunk of the current job, guarded by mutex
+		std::exception_ptr error;
+		std::atomic<bool> failed{ false };
+
+		//only one run at a time
+		std::mutex run_mutex;
+
+		static uint64_t pack(uint32_t next, uint32_t end) {
+			return (uint64_t)next | ((uint64_t)end << 32);
+		}
+
+		/// <summary>
+		/// Take the next chunk from a worker's own queue.
+		/// </summary>
+		bool pop(unsigned int worker, uint32_t& chunk) {
+			std::atomic<uint64_t>& range = this->queues[worker].range;
+			uint64_t current = range.load(std::memory_order_acquire);
+
+			while ((uint32_t)current < (uint32_t)(current >> 32)) {
+				if (range.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel)) {
+					chunk = (uint32_t)current;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Take the back half of another worker's chunks, running the first of them and queueing the rest.
+		/// </summary>
+		bool steal(unsigned int worker, uint32_t& chunk) {
+			for (unsigned int i = 1; i < this->workers; i++) {
+				std::atomic<uint64_t>& range = this->queues[(worker + i) % this->workers].range;
+				uint64_t current = range.load(std::memory_order_acquire);
+
+				while (true) {
+					uint32_t next = (uint32_t)current, end = (uint32_t)(current >> 32);
+					if (next >= end) break;
+
+					//the victim keeps [next, middle), the thief takes [middle, end)
+					uint32_t middle = next + (end - next) / 2;
+
+					if (range.compare_exchange_weak(current, pack(next, middle), std::memory_order_acq_rel)) {
+						chunk = middle;
+						this->queues[worker].range.store(pack(middle + 1, end), std::memory_order_release);
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		/// <summary>
+		/// Run chunks until none are left anywhere or one of them has thrown.
+		/// </summary>
+		void work(unsigned int worker, TASK task, void* context) {
+			uint32_t chunk;
+
+			while (!this->failed.load(std::memory_order_relaxed) && (this->pop(worker, chunk) || this->steal(worker, chunk))) {
+				try {
+					task(context, chunk, worker);
+				}
+				catch (...) {
+					//keep the first exception, run() rethrows it once no worker is using the task any more
+					std::lock_guard<std::mutex> lock(this->mutex);
+					if (this->error == nullptr) this->error = std::current_exception();
+					this->failed.store(true, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Loop of each pool thread, waits for a job, works on it and reports back.
+		/// </summary>
+		void thread_loop(unsigned int worker) {
+			uint64_t seen = 0;
+
+			while (true) {
+				TASK job_task;
+				void* job_context;
+
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					this->wake.wait(lock, [this, seen]() { return this->stopping || this->job != seen; });
+
+					if (this->stopping) return;
+
+					seen = this->job;
+					job_task = this->task;
+					job_context = this->context;
+				}
+
+				this->work(worker, job_task, job_context);
+
+				std::lock_guard<std::mutex> lock(this->mutex);
+				if (--this->active == 0) this->done.notify_one();
+			}
+		}
+
+	public:
+		/// <summary>
+		/// Create a WorkStealingPool.
+		/// </summary>
+		/// <param name="thread_count">Number of workers including the calling thread, 0 uses one per hardware thread.</param>
+		WorkStealingPool(unsigned int thread_count = 0) {
+			if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+			if (thread_count == 0) thread_count = 1;
+
+			this->workers = thread_count;
+			this->queues.reset(new Queue[thread_count]);
+
+			for (unsigned int worker = 1; worker < thread_count; worker++) {
+				this->threads.push_back(std::thread(&WorkStealingPool::thread_loop, this, worker));
+			}
+		}
+
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator= (const WorkStealingPool&) = delete;
+
+		~WorkStealingPool() {
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->stopping = true;
+			}
+
+			this->wake.notify_all();
+
+			for (auto& thread : this->threads) {
+				thread.join();
+			}
+		}
+
+		/// <summary>
+		/// Return a pool with one worker per hardware thread shared by the whole program.
+		/// </summary>
+		static WorkStealingPool& shared() {
+			static WorkStealingPool pool;
+			return pool;
+		}
+
+		/// <summary>
+		/// Return the number of workers, including the calling thread.
+		/// </summary>
+		unsigned int worker_count() const {
+			return this->workers;
+		}
+
+		/// <summary>
+		/// Run task(context, chunk, worker) for every chunk in [0, chunk_count) and wait for all of them to finish.
+		/// If a chunk throws the remaining chunks may be skipped, and the first exception is rethrown after every worker has stopped.
+		/// </summary>
+		void run(unsigned long chunk_count, TASK task, void* context) {
+			if (chunk_count == 0) return;
+
+			std::lock_guard<std::mutex> run_lock(this->run_mutex);
+
+			//don't wake the other threads for a single chunk
+			if (this->workers == 1 || chunk_count == 1) {
+				for (unsigned long chunk = 0; chunk < chunk_count; chunk++) {
+					task(context, chunk, 0);
+				}
+
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+
+				//give every worker an even share to start with
+				for (unsigned int worker = 0; worker < this->workers; worker++) {
+					uint32_t begin = (uint32_t)(chunk_count * worker / this->workers);
+					uint32_t end = (uint32_t)(chunk_count * (worker + 1) / this->workers);
+
+					this->queues[worker].range.store(pack(begin, end), std::memory_order_relaxed);
+				}
+
+				this->task = task;
+				this->context = context;
+				this->active = this->workers - 1;
+				this->error = nullptr;
+				this->failed.store(false, std::memory_order_relaxed);
+				this->job++;
+			}
+
+			this->wake.notify_all();
+
+			//the calling thread is worker 0
+			this->work(0, task, context);
+
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->done.wait(lock, [this]() { return this->active == 0; });
+
+			if (this->error != nullptr) {
+				std::exception_ptr thrown = this->error;
+				this->error = nullptr;
+				std::rethrow_exception(thrown);
+			}
+		}
+
+		/// <summary>
+		/// Run function(chunk, worker) for every chunk in [0, chunk_count) and wait for all of them to finish.
+		/// </summary>
+		template <typename FUNCTION>
+		void run(unsigned long chunk_count, FUNCTION& function) {
+			this->run(chunk_count, [](void* context, unsigned long chunk, unsigned int worker) {
+				(*(FUNCTION*)context)(chunk, worker);
+			}, &function);
+		}
+	};
+};